@@ -16,9 +16,13 @@
 
 #include <stdlib.h>
 
+#include <algorithm>
 #include <array>
+#include <limits>
 #include <tuple>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -32,13 +36,345 @@
 
 namespace {
 
-struct PerVertexClusterStats {
-  gbbs::uintE cluster_id;
+// Statistics of a vertex, or sums of them over the vertices of a cluster.
+struct ClusterSums {
   float volume;
   float intra_cluster_weight;
   float inter_cluster_weight;
+  gbbs::uintE size;
 };
 
+ClusterSums AddClusterSums(const ClusterSums& a, const ClusterSums& b) {
+  return ClusterSums{a.volume + b.volume,
+                     a.intra_cluster_weight + b.intra_cluster_weight,
+                     a.inter_cluster_weight + b.inter_cluster_weight,
+                     a.size + b.size};
+}
+
+// An edge of the original graph between two clusters, as (cluster of the
+// source, cluster of the target, scaled weight).
+using InterClusterEdge = std::tuple<gbbs::uintE, gbbs::uintE, float>;
+
+// Edge aggregation policies for CompressGraph. Each original edge (u, v) of
+// weight w between two clusters contributes `Scale(w, u, v, node_weights)`,
+// the contributions between the same pair of clusters are merged with
+// `Combine` (whose identity is `kIdentity`), and the result is passed through
+// `Normalize` with the node weights of the two clusters. They are template
+// parameters so that the per-edge loops inline them.
+struct MaxAggregation {
+  static constexpr float kIdentity = std::numeric_limits<float>::lowest();
+  static float Scale(float weight, gbbs::uintE, gbbs::uintE,
+                     const std::vector<gbbs::uintE>&) {
+    return weight;
+  }
+  static float Combine(float w1, float w2) { return std::max(w1, w2); }
+  static float Normalize(float weight, gbbs::uintE, gbbs::uintE) {
+    return weight;
+  }
+};
+
+struct SumAggregation {
+  static constexpr float kIdentity = 0;
+  static float Scale(float weight, gbbs::uintE, gbbs::uintE,
+                     const std::vector<gbbs::uintE>&) {
+    return weight;
+  }
+  static float Combine(float w1, float w2) { return w1 + w2; }
+  static float Normalize(float weight, gbbs::uintE, gbbs::uintE) {
+    return weight;
+  }
+};
+
+// Average edge weight between the two clusters, counting node weights.
+struct AverageAggregation : SumAggregation {
+  static float Scale(float weight, gbbs::uintE u, gbbs::uintE v,
+                     const std::vector<gbbs::uintE>& node_weights) {
+    if (node_weights.empty()) return weight;
+    return weight * node_weights[u] * node_weights[v];
+  }
+  static float Normalize(float weight, gbbs::uintE node_weight_u,
+                         gbbs::uintE node_weight_v) {
+    return weight / (static_cast<float>(node_weight_u) * node_weight_v);
+  }
+};
+
+// Total edge weight between the two clusters divided by the smaller node
+// weight.
+struct CutSparsityAggregation : SumAggregation {
+  static float Scale(float weight, gbbs::uintE u, gbbs::uintE v,
+                     const std::vector<gbbs::uintE>& node_weights) {
+    if (node_weights.empty()) return weight;
+    return weight * std::min(node_weights[u], node_weights[v]);
+  }
+  static float Normalize(float weight, gbbs::uintE node_weight_u,
+                         gbbs::uintE node_weight_v) {
+    return weight / std::min(node_weight_u, node_weight_v);
+  }
+};
+
+// The `percentile`-th quantile (in [0, 1]) of the edge weights between the two
+// clusters, or their maximum if there are fewer than `min_edge_count` edges.
+struct PercentileAggregation : MaxAggregation {
+  double percentile;
+  int min_edge_count;
+};
+
+// Bundles up to this size are aggregated sequentially.
+constexpr std::size_t kSequentialBundleSize = 2048;
+
+// Returns the k-th smallest element (0-based) of `weights`, using parallel
+// quickselect partitions until the remaining candidates are few.
+float SelectKthSmallest(parlay::sequence<float> weights, std::size_t k) {
+  while (weights.size() > kSequentialBundleSize) {
+    // Median of three pseudorandom samples as the pivot.
+    std::size_t size = weights.size();
+    std::array<float, 3> samples = {weights[parlay::hash64(size) % size],
+                                    weights[parlay::hash64(size + 1) % size],
+                                    weights[parlay::hash64(size + 2) % size]};
+    std::sort(samples.begin(), samples.end());
+    float pivot = samples[1];
+    auto smaller = parlay::filter(weights, [&](float w) { return w < pivot; });
+    if (k < smaller.size()) {
+      weights = std::move(smaller);
+      continue;
+    }
+    std::size_t num_not_larger =
+        smaller.size() + parlay::count(weights, pivot);
+    if (k < num_not_larger) return pivot;
+    k -= num_not_larger;
+    weights = parlay::filter(weights, [&](float w) { return w > pivot; });
+  }
+  std::nth_element(weights.begin(), weights.begin() + k, weights.end());
+  return weights[k];
+}
+
+// Aggregates the scaled weights `weights` of the edges between two clusters.
+template <class Aggregation, class Seq>
+float AggregateBundle(const Aggregation&, const Seq& weights) {
+  return parlay::reduce(
+      weights,
+      parlay::make_monoid(
+          [](float w1, float w2) { return Aggregation::Combine(w1, w2); },
+          Aggregation::kIdentity));
+}
+
+template <class Seq>
+float AggregateBundle(const PercentileAggregation& aggregation,
+                      const Seq& weights) {
+  std::size_t size = weights.size();
+  if (size < static_cast<std::size_t>(aggregation.min_edge_count)) {
+    return parlay::reduce(weights, parlay::maxm<float>());
+  }
+  std::size_t k = std::min<std::size_t>(
+      size - 1, static_cast<std::size_t>(aggregation.percentile * (size - 1)));
+  if (size <= kSequentialBundleSize) {
+    std::vector<float> bundle(weights.begin(), weights.end());
+    std::nth_element(bundle.begin(), bundle.begin() + k, bundle.end());
+    return bundle[k];
+  }
+  return SelectKthSmallest(parlay::to_sequence(weights), k);
+}
+
+// Returns the node weight of each cluster, i.e. the total weight of its
+// vertices (1 each if `original_node_weights` is empty). Vertices with cluster
+// id UINT_E_MAX are skipped.
+std::vector<gbbs::uintE> ComputeClusterNodeWeights(
+    const std::vector<gbbs::uintE>& original_node_weights,
+    const std::vector<gbbs::uintE>& cluster_ids,
+    gbbs::uintE num_compressed_vertices) {
+  std::size_t n = cluster_ids.size();
+  auto clustered = parlay::filter(
+      parlay::iota<gbbs::uintE>(n),
+      [&](gbbs::uintE i) { return cluster_ids[i] != UINT_E_MAX; });
+  // reduce_by_key groups by cluster id with a parallel semisort.
+  auto cluster_weights =
+      parlay::reduce_by_key(parlay::map(clustered, [&](gbbs::uintE i) {
+        return std::make_pair(cluster_ids[i],
+                              original_node_weights.empty()
+                                  ? gbbs::uintE{1}
+                                  : original_node_weights[i]);
+      }));
+  std::vector<gbbs::uintE> node_weights(num_compressed_vertices,
+                                        gbbs::uintE{0});
+  parlay::parallel_for(0, cluster_weights.size(), [&](std::size_t i) {
+    node_weights[cluster_weights[i].first] = cluster_weights[i].second;
+  });
+  return node_weights;
+}
+
+// Returns the edges of `graph` whose endpoints lie in two different clusters,
+// both with a cluster id other than UINT_E_MAX, with weights scaled by
+// `Aggregation::Scale`.
+template <class Aggregation>
+parlay::sequence<InterClusterEdge> GatherInterClusterEdges(
+    gbbs::symmetric_ptr_graph<gbbs::symmetric_vertex, float>& graph,
+    const std::vector<gbbs::uintE>& cluster_ids,
+    const std::vector<gbbs::uintE>& original_node_weights) {
+  std::size_t n = graph.n;
+  auto is_inter_cluster = [&](gbbs::uintE u, gbbs::uintE v) {
+    return cluster_ids[u] != UINT_E_MAX && cluster_ids[v] != UINT_E_MAX &&
+           cluster_ids[u] != cluster_ids[v];
+  };
+  auto offsets = parlay::sequence<std::size_t>::from_function(
+      n, [&](std::size_t i) -> std::size_t {
+        if (cluster_ids[i] == UINT_E_MAX) return 0;
+        return graph.get_vertex(i).out_neighbors().count(
+            [&](gbbs::uintE u, gbbs::uintE v, float) {
+              return is_inter_cluster(u, v);
+            });
+      });
+  std::size_t num_edges = parlay::scan_inplace(offsets);
+  auto edges = parlay::sequence<InterClusterEdge>::uninitialized(num_edges);
+  parlay::parallel_for(0, n, [&](std::size_t i) {
+    std::size_t k = offsets[i];
+    auto add_edge = [&](gbbs::uintE u, gbbs::uintE v, float weight) {
+      if (is_inter_cluster(u, v)) {
+        edges[k++] = InterClusterEdge{
+            cluster_ids[u], cluster_ids[v],
+            Aggregation::Scale(weight, u, v, original_node_weights)};
+      }
+    };
+    graph.get_vertex(i).out_neighbors().map(add_edge, false);
+  });
+  return edges;
+}
+
+// Aggregates `edges`, which must be sorted by (source cluster, target cluster)
+// with `group_starts` the first index of every (source, target) group, into
+// the CSR of the compressed graph.
+template <class Aggregation>
+research_graph::in_memory::OffsetsEdges AggregateGroupedEdges(
+    const Aggregation& aggregation,
+    const parlay::sequence<InterClusterEdge>& edges,
+    const parlay::sequence<std::size_t>& group_starts,
+    const std::vector<gbbs::uintE>& node_weights,
+    gbbs::uintE num_compressed_vertices) {
+  std::size_t num_groups = group_starts.size();
+  std::unique_ptr<std::tuple<gbbs::uintE, float>[]> compressed_edges(
+      new std::tuple<gbbs::uintE, float>[num_groups]);
+  parlay::parallel_for(0, num_groups, [&](std::size_t i) {
+    std::size_t start = group_starts[i];
+    std::size_t end = i + 1 == num_groups ? edges.size() : group_starts[i + 1];
+    float weight = AggregateBundle(
+        aggregation,
+        parlay::delayed_seq<float>(end - start, [&](std::size_t j) {
+          return std::get<2>(edges[start + j]);
+        }));
+    gbbs::uintE cluster_u = std::get<0>(edges[start]);
+    gbbs::uintE cluster_v = std::get<1>(edges[start]);
+    compressed_edges[i] = std::make_tuple(
+        cluster_v, Aggregation::Normalize(weight, node_weights[cluster_u],
+                                          node_weights[cluster_v]));
+  });
+  research_graph::in_memory::OffsetsEdges result;
+  result.offsets = research_graph::in_memory::GetOffsets(
+      [&](std::size_t i) -> gbbs::uintE {
+        return std::get<0>(edges[group_starts[i]]);
+      },
+      num_groups, num_compressed_vertices);
+  result.edges = std::move(compressed_edges);
+  result.num_edges = num_groups;
+  return result;
+}
+
+// Aggregates `edges` with a hash-based semisort on (source cluster, target
+// cluster) instead of a comparison sort. Only the aggregated edges, usually far
+// fewer, are then radix sorted to lay out the CSR of the compressed graph.
+template <class Aggregation>
+research_graph::in_memory::OffsetsEdges AggregateEdgesByHash(
+    const parlay::sequence<InterClusterEdge>& edges,
+    const std::vector<gbbs::uintE>& node_weights,
+    gbbs::uintE num_compressed_vertices) {
+  auto keyed_edges =
+      parlay::delayed_seq<std::pair<uint64_t, float>>(
+          edges.size(), [&](std::size_t i) {
+            const auto& [cluster_u, cluster_v, weight] = edges[i];
+            return std::make_pair(
+                (static_cast<uint64_t>(cluster_u) << 32) | cluster_v, weight);
+          });
+  auto aggregated = parlay::reduce_by_key(
+      keyed_edges,
+      parlay::make_monoid(
+          [](float w1, float w2) { return Aggregation::Combine(w1, w2); },
+          Aggregation::kIdentity));
+  parlay::integer_sort_inplace(
+      aggregated,
+      [](const std::pair<uint64_t, float>& edge) { return edge.first; });
+
+  std::size_t num_edges = aggregated.size();
+  std::unique_ptr<std::tuple<gbbs::uintE, float>[]> compressed_edges(
+      new std::tuple<gbbs::uintE, float>[num_edges]);
+  parlay::parallel_for(0, num_edges, [&](std::size_t i) {
+    gbbs::uintE cluster_u = aggregated[i].first >> 32;
+    gbbs::uintE cluster_v = aggregated[i].first & UINT_E_MAX;
+    compressed_edges[i] = std::make_tuple(
+        cluster_v,
+        Aggregation::Normalize(aggregated[i].second, node_weights[cluster_u],
+                               node_weights[cluster_v]));
+  });
+  research_graph::in_memory::OffsetsEdges result;
+  result.offsets = research_graph::in_memory::GetOffsets(
+      [&](std::size_t i) -> gbbs::uintE { return aggregated[i].first >> 32; },
+      num_edges, num_compressed_vertices);
+  result.edges = std::move(compressed_edges);
+  result.num_edges = num_edges;
+  return result;
+}
+
+// Aggregates `edges` after grouping them with a parallel comparison sort.
+template <class Aggregation>
+research_graph::in_memory::OffsetsEdges AggregateEdgesBySort(
+    const Aggregation& aggregation, parlay::sequence<InterClusterEdge>& edges,
+    const std::vector<gbbs::uintE>& node_weights,
+    gbbs::uintE num_compressed_vertices) {
+  parlay::sort_inplace(edges, [](const InterClusterEdge& a,
+                                 const InterClusterEdge& b) {
+    return std::tie(std::get<0>(a), std::get<1>(a)) <
+           std::tie(std::get<0>(b), std::get<1>(b));
+  });
+  auto group_starts = parlay::pack_index<std::size_t>(
+      parlay::delayed_seq<bool>(edges.size(), [&](std::size_t i) {
+        return i == 0 || std::get<0>(edges[i]) != std::get<0>(edges[i - 1]) ||
+               std::get<1>(edges[i]) != std::get<1>(edges[i - 1]);
+      }));
+  return AggregateGroupedEdges(aggregation, edges, group_starts, node_weights,
+                               num_compressed_vertices);
+}
+
+// Computes the compressed graph of CompressGraph with the aggregation policy
+// `aggregation`. PERCENTILE needs every bundle's weights, so it is always
+// grouped by sort.
+template <class Aggregation>
+research_graph::in_memory::GraphWithWeights<gbbs::uintE> CompressGraphWith(
+    const Aggregation& aggregation,
+    gbbs::symmetric_ptr_graph<gbbs::symmetric_vertex, float>& original_graph,
+    const std::vector<gbbs::uintE>& original_node_weights,
+    const std::vector<gbbs::uintE>& cluster_ids,
+    gbbs::uintE num_compressed_vertices,
+    research_graph::in_memory::EdgeGrouping edge_grouping) {
+  auto node_weights = ComputeClusterNodeWeights(
+      original_node_weights, cluster_ids, num_compressed_vertices);
+  auto edges = GatherInterClusterEdges<Aggregation>(
+      original_graph, cluster_ids, original_node_weights);
+  research_graph::in_memory::OffsetsEdges offsets_edges;
+  if constexpr (std::is_same<Aggregation, PercentileAggregation>::value) {
+    offsets_edges = AggregateEdgesBySort(aggregation, edges, node_weights,
+                                         num_compressed_vertices);
+  } else {
+    offsets_edges =
+        edge_grouping == research_graph::in_memory::EdgeGrouping::kHash
+            ? AggregateEdgesByHash<Aggregation>(edges, node_weights,
+                                                num_compressed_vertices)
+            : AggregateEdgesBySort(aggregation, edges, node_weights,
+                                   num_compressed_vertices);
+  }
+  return research_graph::in_memory::GraphWithWeights<gbbs::uintE>(
+      research_graph::in_memory::MakeGbbsGraph<float>(
+          offsets_edges.offsets, num_compressed_vertices,
+          std::move(offsets_edges.edges), offsets_edges.num_edges),
+      node_weights);
+}
+
 }  // namespace
 
 namespace research_graph {
@@ -53,100 +389,59 @@ std::vector<ClusterStats> ComputeFinishedClusterStats(
   std::size_t n = G.n;
   std::vector<ClusterStats> aggregate_cluster_stats(num_compressed_vertices,
                                                     {0, 0});
-  std::vector<PerVertexClusterStats> cluster_stats(n);
-
-  // Compute cluster statistics contributions of each vertex
-  auto sum_map_f = [&](gbbs::uintE u, gbbs::uintE v, float weight) -> float {
-    return weight;
-  };
-  parlay::parallel_for(0, n, [&](std::size_t i) {
-    gbbs::uintE cluster_id_i = cluster_ids[i];
-    auto add_m = parlay::addm<float>();
-    auto volume = G.get_vertex(i).out_neighbors().reduce(sum_map_f, add_m);
-    if (cluster_id_i == UINT_E_MAX) {
-      cluster_stats[i] =
-          PerVertexClusterStats{cluster_id_i, volume, float{0}, float{0}};
-    } else {
-      auto intra_cluster_sum_map_f = [&](gbbs::uintE u, gbbs::uintE v,
-                                         float weight) -> float {
-        if (cluster_id_i == cluster_ids[v] && v <= i) return weight;
-        return 0;
-      };
-      auto inter_cluster_sum_map_f = [&](gbbs::uintE u, gbbs::uintE v,
-                                         float weight) -> float {
-        if (cluster_id_i != cluster_ids[v]) return weight;
-        return 0;
-      };
-      auto intra_cluster_weight = G.get_vertex(i).out_neighbors().reduce(
-          intra_cluster_sum_map_f, add_m);
-      auto inter_cluster_weight = G.get_vertex(i).out_neighbors().reduce(
-          inter_cluster_sum_map_f, add_m);
-      cluster_stats[i] = PerVertexClusterStats{
-          cluster_id_i, volume, intra_cluster_weight, inter_cluster_weight};
-    }
-  });
+  auto add_m = parlay::make_monoid(AddClusterSums, ClusterSums{0, 0, 0, 0});
+
+  // Compute cluster statistics contributions of each vertex in one pass over
+  // its neighbors
+  auto vertex_stats = parlay::sequence<ClusterSums>::from_function(
+      n, [&](std::size_t i) {
+        gbbs::uintE cluster_id_i = cluster_ids[i];
+        auto stats_map_f = [&](gbbs::uintE u, gbbs::uintE v,
+                               float weight) -> ClusterSums {
+          if (cluster_id_i != cluster_ids[v]) {
+            return ClusterSums{weight, 0, weight, 0};
+          }
+          return ClusterSums{weight, v <= i ? weight : 0, 0, 0};
+        };
+        auto stats = G.get_vertex(i).out_neighbors().reduce(stats_map_f, add_m);
+        stats.size = 1;
+        return stats;
+      });
 
   // Compute total graph volume
-  auto graph_volume_stats = parallel::Reduce<PerVertexClusterStats>(
-      absl::Span<PerVertexClusterStats>(cluster_stats.data(),
-                                        cluster_stats.size()),
-      [&](PerVertexClusterStats a,
-          PerVertexClusterStats b) -> PerVertexClusterStats {
-        return PerVertexClusterStats{0, a.volume + b.volume, 0, 0};
-      },
-      PerVertexClusterStats{0, 0, 0, 0});
-  float graph_volume = graph_volume_stats.volume;
-
-  // Cluster statistics must now be aggregated per cluster id
-  // Sort cluster statistics by cluster id
-  auto cluster_stats_sort = parallel::ParallelSampleSort<PerVertexClusterStats>(
-      absl::Span<PerVertexClusterStats>(cluster_stats.data(), n),
-      [&](PerVertexClusterStats a, PerVertexClusterStats b) {
-        return a.cluster_id < b.cluster_id;
-      });
+  float graph_volume = parlay::reduce(
+      parlay::delayed_seq<float>(
+          n, [&](std::size_t i) { return vertex_stats[i].volume; }),
+      parlay::addm<float>());
+
+  // Aggregate statistics per cluster id; vertices in finished clusters are
+  // collected in an extra bucket
+  auto cluster_stats = parlay::reduce_by_index(
+      parlay::delayed_seq<std::pair<gbbs::uintE, ClusterSums>>(
+          n,
+          [&](std::size_t i) {
+            gbbs::uintE cluster_id = cluster_ids[i] == UINT_E_MAX
+                                         ? num_compressed_vertices
+                                         : cluster_ids[i];
+            return std::make_pair(cluster_id, vertex_stats[i]);
+          }),
+      num_compressed_vertices + 1, add_m);
 
-  // Obtain the boundary indices where statistics differ by cluster id
-  // These indices are stored in filtered_mark_ids
-  std::vector<gbbs::uintE> filtered_mark_ids =
-      research_graph::parallel::GetBoundaryIndices<gbbs::uintE>(
-          n, [&cluster_stats_sort](std::size_t i, std::size_t j) {
-            return cluster_stats_sort[i].cluster_id ==
-                   cluster_stats_sort[j].cluster_id;
-          });
-  std::size_t num_filtered_mark_ids = filtered_mark_ids.size() - 1;
-
-  // Compute aggregate statistics by cluster id
-  parlay::parallel_for(0, num_filtered_mark_ids, [&](size_t i) {
-    // Combine cluster statistics from start_id_index to end_id_index
-    gbbs::uintE start_id_index = filtered_mark_ids[i];
-    gbbs::uintE end_id_index = filtered_mark_ids[i + 1];
-    auto cluster_id = cluster_stats_sort[start_id_index].cluster_id;
-    if (cluster_id != UINT_E_MAX) {
-      gbbs::uintE cluster_size = end_id_index - start_id_index;
-      auto stats_sum = parallel::Reduce<PerVertexClusterStats>(
-          absl::Span<const PerVertexClusterStats>(
-              cluster_stats_sort.begin() + start_id_index,
-              end_id_index - start_id_index),
-          [&](PerVertexClusterStats a, PerVertexClusterStats b) {
-            return PerVertexClusterStats{
-                0, a.volume + b.volume,
-                a.intra_cluster_weight + b.intra_cluster_weight,
-                a.inter_cluster_weight + b.inter_cluster_weight};
-          },
-          PerVertexClusterStats{0, 0, 0, 0});
-      float density = (cluster_size >= 2)
-                          ? stats_sum.intra_cluster_weight /
-                                (static_cast<float>(cluster_size) *
-                                 (cluster_size - 1) / 2.0)
-                          : 0.0;
-      float volume = stats_sum.volume;
-      float denominator = std::min(volume, graph_volume - volume);
-      float inter_cluster_weight =
-          (denominator < 1e-6) ? 1.0
-                               : stats_sum.inter_cluster_weight / denominator;
-      aggregate_cluster_stats[cluster_id] =
-          ClusterStats(density, inter_cluster_weight);
-    }
+  parlay::parallel_for(0, num_compressed_vertices, [&](std::size_t i) {
+    const ClusterSums& stats_sum = cluster_stats[i];
+    if (stats_sum.size == 0) return;
+    gbbs::uintE cluster_size = stats_sum.size;
+    float density = (cluster_size >= 2)
+                        ? stats_sum.intra_cluster_weight /
+                              (static_cast<float>(cluster_size) *
+                               (cluster_size - 1) / 2.0)
+                        : 0.0;
+    float volume = stats_sum.volume;
+    float denominator = std::min(volume, graph_volume - volume);
+    float inter_cluster_weight =
+        (denominator < 1e-6) ? 1.0
+                             : stats_sum.inter_cluster_weight / denominator;
+    aggregate_cluster_stats[i] = ClusterStats(density, inter_cluster_weight);
   });
 
   return aggregate_cluster_stats;
@@ -240,14 +535,9 @@ CompressGraph(
     gbbs::symmetric_ptr_graph<gbbs::symmetric_vertex, float>& original_graph,
     std::vector<gbbs::uintE>& original_node_weights,
     std::vector<gbbs::uintE>& cluster_ids,
-    const AffinityClustererConfig& affinity_config) {
+    const AffinityClustererConfig& affinity_config,
+    EdgeGrouping edge_grouping) {
   const auto edge_aggregation = affinity_config.edge_aggregation_function();
-  // TODO(jeshi): Support percentile edge aggregation
-  if (edge_aggregation == AffinityClustererConfig::PERCENTILE)
-    return absl::UnimplementedError(
-        "PERCENTILE aggregation for parallel affinity clusterer is "
-        "unimplemented.");
-  std::size_t n = original_graph.n;
   // Obtain the number of vertices in the new graph
   gbbs::uintE num_compressed_vertices =
       1 + parallel::Reduce<gbbs::uintE>(
@@ -259,86 +549,40 @@ CompressGraph(
               },
               UINT_E_MAX);
 
-  // Retrieve node weights
-  std::vector<gbbs::uintE> node_weights(num_compressed_vertices,
-                                        gbbs::uintE{0});
-  // TODO(jeshi): This could be made parallel, although perhaps it would be
-  // too much overhead.
-  for (std::size_t i = 0; i < n; ++i) {
-    if (cluster_ids[i] != UINT_E_MAX)
-      node_weights[cluster_ids[i]] += original_node_weights.empty() ? 1 : original_node_weights[i];
-  }
-
-  // Compute new inter cluster edges using sorting
-  // TODO(jeshi): Allow optionality to choose between aggregation methods
-  std::function<float(float, float)> edge_aggregation_func;
-  std::function<float(std::tuple<gbbs::uintE, gbbs::uintE, float>)> scale_func =
-    [](std::tuple<gbbs::uintE, gbbs::uintE, float> v) {
-      return std::get<2>(v);
-    };
   switch (edge_aggregation) {
     case AffinityClustererConfig::MAX:
-      edge_aggregation_func = [](float w1, float w2) { return std::max(w1, w2); };
-      break;
+      return CompressGraphWith(MaxAggregation{}, original_graph,
+                               original_node_weights, cluster_ids,
+                               num_compressed_vertices, edge_grouping);
     case AffinityClustererConfig::SUM:
-      edge_aggregation_func = [](float w1, float w2) { return w1 + w2; };
-      break;
+      return CompressGraphWith(SumAggregation{}, original_graph,
+                               original_node_weights, cluster_ids,
+                               num_compressed_vertices, edge_grouping);
     case AffinityClustererConfig::DEFAULT_AVERAGE:
-      edge_aggregation_func = [](float w1, float w2) { return w1 + w2; };
-      if (!original_node_weights.empty()) {
-        scale_func = [&original_node_weights] (std::tuple<gbbs::uintE, gbbs::uintE, float> v) {
-          float scaling_factor = original_node_weights[std::get<0>(v)] * original_node_weights[std::get<1>(v)];
-          return std::get<2>(v) * scaling_factor;
-        };
-      }
-      break;
+      return CompressGraphWith(AverageAggregation{}, original_graph,
+                               original_node_weights, cluster_ids,
+                               num_compressed_vertices, edge_grouping);
     case AffinityClustererConfig::CUT_SPARSITY:
-      edge_aggregation_func = [](float w1, float w2) { return w1 + w2; };
-      if (!original_node_weights.empty()) {
-        scale_func = [&original_node_weights] (std::tuple<gbbs::uintE, gbbs::uintE, float> v) {
-          float scaling_factor = std::min(original_node_weights[std::get<0>(v)], original_node_weights[std::get<1>(v)]);
-          return std::get<2>(v) * scaling_factor;
-        };
+      return CompressGraphWith(CutSparsityAggregation{}, original_graph,
+                               original_node_weights, cluster_ids,
+                               num_compressed_vertices, edge_grouping);
+    case AffinityClustererConfig::PERCENTILE: {
+      double percentile = affinity_config.percentile_linkage_value();
+      if (percentile < 0 || percentile > 1) {
+        return absl::InvalidArgumentError(
+            "percentile_linkage_value must be in [0, 1]");
       }
-      break;
+      PercentileAggregation aggregation;
+      aggregation.percentile = percentile;
+      aggregation.min_edge_count =
+          affinity_config.min_edge_count_for_percentile_linkage();
+      return CompressGraphWith(aggregation, original_graph,
+                               original_node_weights, cluster_ids,
+                               num_compressed_vertices, edge_grouping);
+    }
     default:
-      std::cout << "Unkown edge aggregation method" << std::endl; exit(0);
-  }
-
-  OffsetsEdges offsets_edges = ComputeInterClusterEdgesSort(
-      original_graph, cluster_ids, num_compressed_vertices,
-      edge_aggregation_func, std::not_equal_to<gbbs::uintE>(), scale_func);
-  std::vector<gbbs::uintE> offsets = offsets_edges.offsets;
-  std::size_t num_edges = offsets_edges.num_edges;
-  std::unique_ptr<std::tuple<gbbs::uintE, float>[]> edges =
-      std::move(offsets_edges.edges);
-
-  if (edge_aggregation == AffinityClustererConfig::SUM ||
-      edge_aggregation == AffinityClustererConfig::MAX) {
-    return GraphWithWeights<gbbs::uintE>(MakeGbbsGraph<float>(offsets, num_compressed_vertices,
-                                std::move(edges), num_edges), node_weights);
+      return absl::InvalidArgumentError("Unknown edge aggregation method");
   }
-
-  // Scale edge weights
-  parlay::parallel_for(0, num_compressed_vertices, [&](std::size_t i) {
-    auto offset = offsets[i];
-    auto degree = offsets[i + 1] - offset;
-    for (std::size_t j = 0; j < degree; j++) {
-      const auto& edge = edges[offset + j];
-      float scaling_factor = 0;
-      if (edge_aggregation == AffinityClustererConfig::DEFAULT_AVERAGE) {
-        scaling_factor = node_weights[i] * node_weights[std::get<0>(edge)];
-      } else if (edge_aggregation == AffinityClustererConfig::CUT_SPARSITY) {
-        scaling_factor =
-            std::min(node_weights[i], node_weights[std::get<0>(edge)]);
-      }
-      edges[offset + j] = std::make_tuple(std::get<0>(edge),
-                                          std::get<1>(edge) / scaling_factor);
-    }
-  });
-
-  return GraphWithWeights<gbbs::uintE>(MakeGbbsGraph<float>(offsets, num_compressed_vertices,
-                              std::move(edges), num_edges), node_weights);
 }
 
 InMemoryClusterer::Clustering ComputeClusters(
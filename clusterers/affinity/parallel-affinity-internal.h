@@ -49,6 +49,11 @@ absl::StatusOr<std::vector<gbbs::uintE>> NearestNeighborLinkage(
     gbbs::symmetric_ptr_graph<gbbs::symmetric_vertex, float>& G,
     float weight_threshold);
 
+// How CompressGraph groups the edges between each pair of clusters before
+// aggregating them: with a parallel comparison sort, or with a hash-based
+// semisort.
+enum class EdgeGrouping { kSort, kHash };
+
 // Compute a compressed graph where vertices are given by cluster ids, and edges
 // are aggregated according to affinity_config. A cluster id of UINT_E_MAX
 // means that the corresponding vertex has already been clustered into
@@ -59,7 +64,8 @@ CompressGraph(
     gbbs::symmetric_ptr_graph<gbbs::symmetric_vertex, float>& original_graph,
     std::vector<gbbs::uintE>& original_node_weights,
     std::vector<gbbs::uintE>& cluster_ids,
-    const AffinityClustererConfig& affinity_config);
+    const AffinityClustererConfig& affinity_config,
+    EdgeGrouping edge_grouping = EdgeGrouping::kSort);
 
 // Determine which clusters, as given by cluster_ids, are "finished", where
 // "finished" is defined by AffinityClustererConfig (e.g., a cluster of
@@ -21,6 +21,7 @@
 
 #include "absl/status/statusor.h"
 #include "clusterers/affinity/parallel-affinity-internal.h"
+#include "clusterers/affinity/parallel_affinity_config.pb.h"
 #include "parcluster/api/config.pb.h"
 #include "parcluster/api/gbbs-graph.h"
 #include "parcluster/api/in-memory-clusterer-base.h"
@@ -67,9 +68,78 @@ double GetAffinityWeightThreshold(const AffinityClustererConfig& affinity_config
   return 0.0;
 }
 
+// Returns the affinity options of a run, which may be given either in
+// `config` or in its ParallelAffinityClustererConfig.
+const AffinityClustererConfig& GetAffinityConfig(
+    const ClustererConfig& config,
+    const ParallelAffinityClustererConfig& parallel_affinity_config) {
+  return parallel_affinity_config.has_affinity_clusterer_config()
+             ? parallel_affinity_config.affinity_clusterer_config()
+             : config.affinity_clusterer_config();
+}
+
+EdgeGrouping GetEdgeGrouping(
+    const ParallelAffinityClustererConfig& parallel_affinity_config) {
+  return parallel_affinity_config.edge_grouping() ==
+                 ParallelAffinityClustererConfig::HASH
+             ? EdgeGrouping::kHash
+             : EdgeGrouping::kSort;
+}
+
+// Adds the merges of one round to `nodes`. `level_ids[v]` is the dendrogram
+// node of vertex v of the round's graph, and `compressed_cluster_ids[v]` its
+// cluster after the round. The k > 1 members of a cluster are merged by a
+// chain of k - 1 binary merges at `merge_similarity`. Returns the dendrogram
+// node of each cluster, or kNoParentId for cluster ids without members, which
+// NearestNeighborLinkage leaves since its ids are not contiguous.
+std::vector<gbbs::uintE> AddMerges(
+    const std::vector<gbbs::uintE>& level_ids,
+    const std::vector<gbbs::uintE>& compressed_cluster_ids,
+    double merge_similarity,
+    std::vector<ParallelAffinityClusterer::Dendrogram::DendrogramNode>* nodes) {
+  std::size_t num_clusters =
+      1 + parlay::reduce(compressed_cluster_ids, parlay::maxm<gbbs::uintE>());
+  auto members = parlay::group_by_index(
+      parlay::delayed_seq<std::pair<gbbs::uintE, gbbs::uintE>>(
+          level_ids.size(),
+          [&](std::size_t v) {
+            return std::make_pair(compressed_cluster_ids[v], level_ids[v]);
+          }),
+      num_clusters);
+  auto new_node_offsets = parlay::map(members, [](const auto& cluster) {
+    return std::max<std::size_t>(cluster.size(), 1) - 1;
+  });
+  std::size_t num_new_nodes = parlay::scan_inplace(new_node_offsets);
+
+  std::size_t first_new_node = nodes->size();
+  nodes->resize(first_new_node + num_new_nodes,
+                {ParallelAffinityClusterer::Dendrogram::kNoParentId, 0.0});
+  std::vector<gbbs::uintE> cluster_level_ids(num_clusters);
+  parlay::parallel_for(0, num_clusters, [&](std::size_t c) {
+    const auto& cluster = members[c];
+    if (cluster.empty()) {
+      cluster_level_ids[c] = ParallelAffinityClusterer::Dendrogram::kNoParentId;
+      return;
+    }
+    gbbs::uintE merged = cluster[0];
+    for (std::size_t j = 1; j < cluster.size(); j++) {
+      gbbs::uintE parent = first_new_node + new_node_offsets[c] + j - 1;
+      (*nodes)[merged] = {parent, merge_similarity};
+      (*nodes)[cluster[j]] = {parent, merge_similarity};
+      merged = parent;
+    }
+    cluster_level_ids[c] = merged;
+  });
+  return cluster_level_ids;
+}
+
 absl::StatusOr<ParallelAffinityClusterer::Clustering>
 ParallelAffinityClusterer::Cluster(const ClustererConfig& config) const {
-  const AffinityClustererConfig& affinity_config = config.affinity_clusterer_config();
+  ParallelAffinityClustererConfig parallel_affinity_config;
+  config.any_config().UnpackTo(&parallel_affinity_config);
+  const AffinityClustererConfig& affinity_config =
+      GetAffinityConfig(config, parallel_affinity_config);
+  const EdgeGrouping edge_grouping = GetEdgeGrouping(parallel_affinity_config);
   std::size_t n = graph_.Graph()->n;
 
   // Initially each vertex is its own cluster.
@@ -83,6 +153,10 @@ ParallelAffinityClusterer::Cluster(const ClustererConfig& config) const {
 
   std::vector<gbbs::uintE> node_weights;
   std::cout << "Affinity num iterations = " << affinity_config.num_iterations() << std::endl;
+  std::cout << "Edge grouping = "
+            << ParallelAffinityClustererConfig::EdgeGrouping_Name(
+                   parallel_affinity_config.edge_grouping())
+            << std::endl;
 
   for (int i = 0; i < affinity_config.num_iterations(); ++i) {
 
@@ -100,8 +174,10 @@ ParallelAffinityClusterer::Cluster(const ClustererConfig& config) const {
 
     cluster_ids = FlattenClustering(cluster_ids, compressed_cluster_ids);
 
-    // TODO(jeshi): Performance can be improved by not finding finished
-    // clusters on the last round
+    // Every remaining cluster is emitted after the last round, so finished
+    // clusters need not be separated out.
+    if (i == affinity_config.num_iterations() - 1) break;
+
     auto new_clusters =
         FindFinishedClusters(*(graph_.Graph()), affinity_config, cluster_ids);
 
@@ -114,12 +190,13 @@ ParallelAffinityClusterer::Cluster(const ClustererConfig& config) const {
     bool to_exit = parlay::reduce(
         exit_seq,
         parlay::make_monoid([](bool a, bool b) { return a && b; }, true));
-    if (to_exit || i == affinity_config.num_iterations() - 1) break;
+    if (to_exit) break;
 
     GraphWithWeights<gbbs::uintE> new_compressed_graph;
     ASSIGN_OR_RETURN(
       new_compressed_graph,
-      CompressGraph(*current_graph, node_weights, compressed_cluster_ids, affinity_config));
+      CompressGraph(*current_graph, node_weights, compressed_cluster_ids,
+                    affinity_config, edge_grouping));
     compressed_graph.swap(new_compressed_graph.graph);
     node_weights = new_compressed_graph.node_weights;
   }
@@ -134,5 +211,58 @@ ParallelAffinityClusterer::Cluster(const ClustererConfig& config) const {
   return clustering;
 }
 
+absl::StatusOr<ParallelAffinityClusterer::Dendrogram>
+ParallelAffinityClusterer::HierarchicalCluster(
+    const ClustererConfig& config) const {
+  ParallelAffinityClustererConfig parallel_affinity_config;
+  config.any_config().UnpackTo(&parallel_affinity_config);
+  const AffinityClustererConfig& affinity_config =
+      GetAffinityConfig(config, parallel_affinity_config);
+  const EdgeGrouping edge_grouping = GetEdgeGrouping(parallel_affinity_config);
+  std::size_t n = graph_.Graph()->n;
+
+  // The leaves are the vertices, which are the first level's clusters.
+  std::vector<Dendrogram::DendrogramNode> nodes(
+      n, {Dendrogram::kNoParentId, 0.0});
+  std::vector<gbbs::uintE> level_ids(n);
+  parlay::parallel_for(0, n, [&](std::size_t i) { level_ids[i] = i; });
+
+  std::unique_ptr<gbbs::symmetric_ptr_graph<gbbs::symmetric_vertex, float>>
+      compressed_graph;
+  std::vector<gbbs::uintE> node_weights;
+  std::cout << "Affinity num iterations = " << affinity_config.num_iterations()
+            << std::endl;
+
+  for (int i = 0; i < affinity_config.num_iterations() && level_ids.size() > 1;
+       ++i) {
+    double weight_threshold = GetAffinityWeightThreshold(affinity_config, i);
+    gbbs::symmetric_ptr_graph<gbbs::symmetric_vertex, float>* current_graph =
+        (i == 0) ? graph_.Graph() : compressed_graph.get();
+
+    std::vector<gbbs::uintE> compressed_cluster_ids;
+    ASSIGN_OR_RETURN(compressed_cluster_ids,
+                     NearestNeighborLinkage(*current_graph, weight_threshold));
+
+    std::cout << "Iteration: " << i << " n = " << current_graph->n
+              << " m = " << current_graph->m << std::endl;
+
+    level_ids =
+        AddMerges(level_ids, compressed_cluster_ids, weight_threshold, &nodes);
+    if (i == affinity_config.num_iterations() - 1) break;
+
+    GraphWithWeights<gbbs::uintE> new_compressed_graph;
+    ASSIGN_OR_RETURN(
+        new_compressed_graph,
+        CompressGraph(*current_graph, node_weights, compressed_cluster_ids,
+                      affinity_config, edge_grouping));
+    compressed_graph.swap(new_compressed_graph.graph);
+    node_weights = new_compressed_graph.node_weights;
+  }
+
+  Dendrogram dendrogram(0);
+  RETURN_IF_ERROR(dendrogram.Init(std::move(nodes), n));
+  return dendrogram;
+}
+
 }  // namespace in_memory
 }  // namespace research_graph
@@ -38,6 +38,12 @@ class ParallelAffinityClusterer : public InMemoryClusterer {
   absl::StatusOr<Clustering> Cluster(
       const ClustererConfig& config) const override;
 
+  // Returns the hierarchy of the nearest-neighbor merges made over
+  // num_iterations rounds, ignoring active_cluster_conditions. Each round's
+  // merges are binary with the round's weight threshold as merge similarity.
+  absl::StatusOr<Dendrogram> HierarchicalCluster(
+      const ClustererConfig& config) const override;
+
  private:
   GbbsGraph graph_;
 };
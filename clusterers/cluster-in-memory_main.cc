@@ -132,9 +132,9 @@ absl::Status WriteClusteringNoZeroDegree(const char* filename,
   return absl::OkStatus();
 }
 
-absl::Status WriteDendrogram(const char* filename,
-                             graph_mining::in_memory::Dendrogram dendrogram) {
-  auto kNoParentId = graph_mining::in_memory::Dendrogram::kNoParentId;
+template <class Dendrogram>
+absl::Status WriteDendrogram(const char* filename, const Dendrogram& dendrogram) {
+  auto kNoParentId = Dendrogram::kNoParentId;
   std::ofstream file{filename};
   if (!file.is_open()) {
     return absl::NotFoundError("Unable to open file.");
@@ -152,11 +152,21 @@ bool IsAnyProto(const std::string& clusterer_name){
   return (clusterer_name == "ExampleClusterer") || (clusterer_name == "TectonicClusterer") || 
          (clusterer_name == "KCoreClusterer") || (clusterer_name == "ConnectivityClusterer") || 
          (clusterer_name == "LDDClusterer") || (clusterer_name == "ScanClusterer") || 
-         (clusterer_name == "LabelPropagationClusterer") || (clusterer_name == "SLPAClusterer");
+         (clusterer_name == "LabelPropagationClusterer") || (clusterer_name == "SLPAClusterer") ||
+         (clusterer_name == "NativeParallelAffinityClusterer");
 }
 
 std::string FormatClustererConfig(const std::string& clusterer_name, const std::string& clusterer_config){
   if (clusterer_config == "" || !IsAnyProto(clusterer_name)) return clusterer_config;
+  if (clusterer_name == "NativeParallelAffinityClusterer") {
+    // The config names the fields of ParallelAffinityClustererConfig, e.g.
+    // "edge_grouping: HASH" or "affinity_clusterer_config {...}", and may have
+    // no braces at all, so all of it goes into the any_config.
+    std::string clusterer_config_formatted = "any_config {[type.googleapis.com/research_graph.in_memory.ParallelAffinityClustererConfig] {";
+    clusterer_config_formatted.append(clusterer_config);
+    clusterer_config_formatted.append("}}");
+    return clusterer_config_formatted;
+  }
   std::size_t index_left_brace = clusterer_config.find('{');
   std::size_t index_right_brace = clusterer_config.rfind('}');
   if (index_left_brace == std::string::npos || index_right_brace == std::string::npos) {
@@ -195,6 +205,8 @@ absl::Status Main() {
   if (clusterer_name == "ParallelAffinityClusterer") {
     using_google_clusterer = true;
     clusterer_google.reset(new graph_mining::in_memory::ParallelAffinityClusterer);
+  } else if (clusterer_name == "NativeParallelAffinityClusterer") {
+    clusterer.reset(new ParallelAffinityClusterer);
   } else if (clusterer_name == "ExampleClusterer") {
     clusterer.reset(new ExampleClusterer);
   } else if (clusterer_name == "LDDClusterer") {
@@ -286,17 +298,13 @@ absl::Status Main() {
   auto begin_cluster = std::chrono::steady_clock::now();
   std::cout << "Calling clustering." << std::endl;
   if (is_hierarchical) {
-    // TODO(jeshi): Not fully implemented
-    // InMemoryClusterer::Dendrogram dendrogram;
-    std::cout << "Here." << std::endl;
-
-    // if (using_google_clusterer){
-    ASSIGN_OR_RETURN(auto dendrogram, clusterer_google->HierarchicalCluster(config_google));
-    // }else{
-    //   ASSIGN_OR_RETURN(auto dendrogram, clusterer->HierarchicalCluster(config));
-    // }
-    std::cout << "Here: Dend computed." << std::endl;
-    // TODO(jeshi): Writing pre-emptively for testing.
+    if (using_google_clusterer){
+      ASSIGN_OR_RETURN(auto dendrogram, clusterer_google->HierarchicalCluster(config_google));
+      auto end_cluster = std::chrono::steady_clock::now();
+      PrintTime(begin_cluster, end_cluster, "Cluster");
+      return WriteDendrogram(output_file.c_str(), dendrogram);
+    }
+    ASSIGN_OR_RETURN(auto dendrogram, clusterer->HierarchicalCluster(config));
     auto end_cluster = std::chrono::steady_clock::now();
     PrintTime(begin_cluster, end_cluster, "Cluster");
     return WriteDendrogram(output_file.c_str(), dendrogram);
@@ -34,9 +34,16 @@ absl::StatusOr<ClusteringStatistics> GetStats(const GbbsGraph& graph,
   const bool compute_ari = clustering_stats_config.compute_ari();
   const bool compute_precision_recall = clustering_stats_config.compute_precision_recall();
   const bool compute_nmi = clustering_stats_config.compute_nmi();
+  const bool compute_ami = clustering_stats_config.compute_ami();
+  const bool compute_v_measure = clustering_stats_config.compute_v_measure();
+  const bool compute_pair_precision_recall =
+      clustering_stats_config.compute_pair_precision_recall();
+  const bool use_contingency_table =
+      compute_ari || compute_nmi || compute_ami || compute_v_measure ||
+      compute_pair_precision_recall;
 
   auto begin_read = std::chrono::steady_clock::now();
-  if (compute_ari || compute_precision_recall || compute_nmi){
+  if (use_contingency_table || compute_precision_recall){
     if (input_communities.empty()){
       return absl::InvalidArgumentError(
         absl::StrFormat("input_communities is not provided."));
@@ -62,29 +69,60 @@ absl::StatusOr<ClusteringStatistics> GetStats(const GbbsGraph& graph,
     });
   });
 
-  ComputeCorrelationObjective(graph, clustering, &clustering_stats, cluster_ids, clustering_stats_config);
+  // Edge weight sums shared by the objectives at all resolutions
+  ObjectiveSums objective_sums;
+  if (!clustering_stats_config.correlation_resolutions().empty() ||
+      !clustering_stats_config.modularity_resolutions().empty()) {
+    objective_sums = ComputeObjectiveSums(graph, clustering, cluster_ids);
+  }
+  ComputeCorrelationObjective(graph, clustering, &clustering_stats, cluster_ids, clustering_stats_config, objective_sums);
   auto end_corr = std::chrono::steady_clock::now();
   PrintTime(end_comm, end_corr, "Compute Correlation");
-  ComputeModularityObjective(graph, clustering, &clustering_stats, cluster_ids, clustering_stats_config);
+  ComputeModularityObjective(graph, clustering, &clustering_stats, cluster_ids, clustering_stats_config, objective_sums);
   auto end_modularity = std::chrono::steady_clock::now();
   PrintTime(end_corr, end_modularity, "Compute Modularity");
-  ComputeDiameter(graph, clustering, &clustering_stats, cluster_ids, clustering_stats_config);
+
+  // The subgraphs of all clusters, shared by the per-cluster statistics
+  const bool use_partitioned_graph =
+      clustering_stats_config.compute_num_component() ||
+      clustering_stats_config.compute_diameter() ||
+      clustering_stats_config.compute_triangle_density();
+  ClusterPartitionedGraph partitioned_graph;
+  if (use_partitioned_graph) {
+    partitioned_graph = PartitionByCluster(graph, clustering, cluster_ids);
+  }
+  auto end_partition = std::chrono::steady_clock::now();
+  PrintTime(end_modularity, end_partition, "Partition Graph By Cluster");
+  ComputeDiameter(graph, clustering, &clustering_stats, cluster_ids, clustering_stats_config, partitioned_graph);
   auto end_diameter = std::chrono::steady_clock::now();
-  PrintTime(end_modularity, end_diameter, "Compute Diameter");
+  PrintTime(end_partition, end_diameter, "Compute Diameter");
   ComputeEdgeDensity(graph, clustering, &clustering_stats, cluster_ids, clustering_stats_config);
   auto end_edge_density = std::chrono::steady_clock::now();
   PrintTime(end_diameter, end_edge_density, "Compute EdgeDensity");
-  ComputeTriangleDensity(graph, clustering, &clustering_stats, cluster_ids, clustering_stats_config);
+  ComputeTriangleDensity(graph, clustering, &clustering_stats, cluster_ids, clustering_stats_config, partitioned_graph);
   auto end_triangle_density = std::chrono::steady_clock::now();
   PrintTime(end_edge_density, end_triangle_density, "Compute Triangle Density");
 
   size_t n = graph.Graph()->n;
-  ComputeARI(n, clustering, &clustering_stats, communities, clustering_stats_config);
+  ContingencyTable contingency_table;
+  if (use_contingency_table) {
+    contingency_table = ComputeContingencyTable(clustering, communities);
+  }
+  auto end_contingency = std::chrono::steady_clock::now();
+  PrintTime(end_triangle_density, end_contingency, "Compute Contingency Table");
+  ComputeARI(n, contingency_table, &clustering_stats, clustering_stats_config);
   auto end_ari = std::chrono::steady_clock::now();
-  PrintTime(end_triangle_density, end_ari, "Compute ARI");
-  ComputeNMI(n, clustering, &clustering_stats, communities, clustering_stats_config);
+  PrintTime(end_contingency, end_ari, "Compute ARI");
+  ComputeNMI(n, contingency_table, &clustering_stats, clustering_stats_config);
   auto end_nmi = std::chrono::steady_clock::now();
   PrintTime(end_ari, end_nmi, "Compute NMI");
+  ComputeAMI(n, contingency_table, &clustering_stats, clustering_stats_config);
+  ComputeVMeasure(n, contingency_table, &clustering_stats, clustering_stats_config);
+  auto end_ami = std::chrono::steady_clock::now();
+  PrintTime(end_nmi, end_ami, "Compute AMI and V-measure");
+  ComputePairPrecisionRecall(contingency_table, &clustering_stats, clustering_stats_config);
+  auto end_pair = std::chrono::steady_clock::now();
+  PrintTime(end_ami, end_pair, "Compute Pair Precision Recall");
 
 
   return clustering_stats;
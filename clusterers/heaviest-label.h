@@ -0,0 +1,57 @@
+// Copyright 2020 The Google Research Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PARALLEL_CLUSTERING_CLUSTERERS_HEAVIEST_LABEL_H_
+#define PARALLEL_CLUSTERING_CLUSTERERS_HEAVIEST_LABEL_H_
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#include "parcluster/api/gbbs-graph.h"
+
+namespace research_graph {
+namespace in_memory {
+
+// Orders (label, total weight) pairs by weight, breaking ties towards the
+// larger label.
+struct LighterLabel {
+  bool operator()(const std::pair<gbbs::uintE, double>& p1,
+                  const std::pair<gbbs::uintE, double>& p2) const {
+    return p1.second < p2.second ||
+           (p1.second == p2.second && p1.first < p2.first);
+  }
+};
+
+// Returns the label with the largest total weight in `label_weights_sum`,
+// accumulated sequentially by label.
+inline gbbs::uintE HeaviestLabel(
+    const std::map<gbbs::uintE, double>& label_weights_sum) {
+  return std::max_element(label_weights_sum.begin(), label_weights_sum.end(),
+                          LighterLabel())
+      ->first;
+}
+
+// Returns the label with the largest total weight in `label_weights_sum`, a
+// sequence of (label, total weight) pairs such as the output of
+// parlay::reduce_by_key. Gives the same label as the std::map overload.
+inline gbbs::uintE HeaviestLabel(
+    const parlay::sequence<std::pair<gbbs::uintE, double>>& label_weights_sum) {
+  return parlay::max_element(label_weights_sum, LighterLabel())->first;
+}
+
+}  // namespace in_memory
+}  // namespace research_graph
+
+#endif  // PARALLEL_CLUSTERING_CLUSTERERS_HEAVIEST_LABEL_H_
@@ -1,24 +1,137 @@
 #include "clusterers/labelprop_clusterer/labelprop-clusterer.h"
 
 #include <algorithm>
+#include <fstream>
 #include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "clusterers/heaviest-label.h"
 #include "clusterers/labelprop_clusterer/labelprop_config.pb.h"
 
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "gbbs/bridge.h"
+#include "gbbs/edge_map_data.h"
+#include "gbbs/vertex_subset.h"
 #include "parcluster/api/config.pb.h"
 #include "parcluster/api/gbbs-graph.h"
 #include "parcluster/api/in-memory-clusterer-base.h"
 #include "parcluster/api/parallel/parallel-graph-utils.h"
 #include "parcluster/api/status_macros.h"
 
-#include "parlay/hash_table.h"
-
 namespace research_graph {
 namespace in_memory {
 
+namespace {
+
+// Returns the seed of a warm start as a dense labeling, with gbbs::UINT_E_MAX
+// for unseeded nodes, or an empty sequence if `config` has no seed.
+absl::StatusOr<parlay::sequence<gbbs::uintE>> ReadSeedLabels(
+    const LabelPropagationClustererConfig& config, std::size_t n) {
+  if (!config.seed_clustering_file().empty()) {
+    std::ifstream file{config.seed_clustering_file()};
+    if (!file.is_open()) {
+      return absl::NotFoundError("Unable to open seed clustering file.");
+    }
+    auto seed = parlay::sequence<gbbs::uintE>(n, gbbs::UINT_E_MAX);
+    gbbs::uintE cluster_id = 0;
+    std::string line;
+    while (std::getline(file, line)) {
+      std::stringstream ss(line);
+      std::string item;
+      while (std::getline(ss, item, '\t')) {
+        if (item.empty()) continue;
+        uint64_t node_id;
+        if (!absl::SimpleAtoi(item, &node_id)) {
+          return absl::InvalidArgumentError(
+              "seed clustering contains a malformed node id");
+        }
+        if (node_id >= n) {
+          return absl::InvalidArgumentError(
+              "seed clustering contains a node id larger than the graph");
+        }
+        seed[node_id] = cluster_id;
+      }
+      cluster_id++;
+    }
+    return seed;
+  }
+  if (config.seed_labels_size() > 0) {
+    if (static_cast<std::size_t>(config.seed_labels_size()) != n) {
+      return absl::InvalidArgumentError(
+          "seed_labels must have one entry per node");
+    }
+    return parlay::sequence<gbbs::uintE>::from_function(
+        n, [&](std::size_t i) { return config.seed_labels(i); });
+  }
+  return parlay::sequence<gbbs::uintE>();
+}
+
+// Returns the initial labels of a run. Every seed cluster is relabeled by its
+// smallest member, so that seed labels cannot collide with the singleton
+// labels of unseeded nodes.
+parlay::sequence<gbbs::uintE> InitialLabels(
+    const parlay::sequence<gbbs::uintE>& seed, std::size_t n) {
+  auto clusters = parlay::sequence<gbbs::uintE>::from_function(
+      n, [&](std::size_t i) { return i; });
+  if (seed.empty()) return clusters;
+
+  auto seeded = parlay::pack_index<gbbs::uintE>(parlay::delayed_seq<bool>(
+      n, [&](std::size_t i) { return seed[i] != gbbs::UINT_E_MAX; }));
+  auto by_label = parlay::sort(parlay::map(seeded, [&](gbbs::uintE node_id) {
+    return std::make_pair(seed[node_id], node_id);
+  }));
+  auto starts = parlay::pack_index(
+      parlay::delayed_seq<bool>(by_label.size(), [&](std::size_t i) {
+        return i == 0 || by_label[i].first != by_label[i - 1].first;
+      }));
+  parlay::parallel_for(0, starts.size(), [&](std::size_t i) {
+    std::size_t end = i + 1 == starts.size() ? by_label.size() : starts[i + 1];
+    gbbs::uintE representative = by_label[starts[i]].second;
+    parlay::parallel_for(starts[i], end, [&](std::size_t j) {
+      clusters[by_label[j].second] = representative;
+    });
+  });
+  return clusters;
+}
+
+// edgeMap functor that adds the neighbors of updated vertices to the next
+// frontier. `is_active` deduplicates targets within a round and is cleared for
+// the new frontier once the edgeMap returns. Pinned vertices are never
+// activated.
+struct ActivateNeighbors {
+  bool* is_active;
+  const bool* is_pinned;
+
+  ActivateNeighbors(bool* _is_active, const bool* _is_pinned)
+      : is_active(_is_active), is_pinned(_is_pinned) {}
+
+  template <class W>
+  inline bool update(const gbbs::uintE& s, const gbbs::uintE& d, const W& w) {
+    if (is_active[d]) return false;
+    is_active[d] = true;
+    return true;
+  }
+
+  template <class W>
+  inline bool updateAtomic(const gbbs::uintE& s, const gbbs::uintE& d,
+                           const W& w) {
+    return !is_active[d] &&
+           gbbs::atomic_compare_and_swap(&is_active[d], false, true);
+  }
+
+  inline bool cond(const gbbs::uintE& d) {
+    return !is_active[d] && !is_pinned[d];
+  }
+};
+
+}  // namespace
+
 absl::StatusOr<LabelPropagationClusterer::Clustering>
 LabelPropagationClusterer::Cluster(const ClustererConfig& config) const {
   std::size_t n = graph_.Graph()->n;
@@ -29,6 +142,7 @@ LabelPropagationClusterer::Cluster(const ClustererConfig& config) const {
   int update_threshold = labelprop_config.update_threshold();
   gbbs::uintE par_threshold = labelprop_config.par_threshold();
   bool async = labelprop_config.async();
+  bool pin_seed_labels = labelprop_config.pin_seed_labels();
 
 std::cout << "max_iteration: " << max_iteration << std::endl;
 std::cout << "update_threshold: " << update_threshold << std::endl;
@@ -43,47 +157,64 @@ std::cout << "async: " << async << std::endl;
     std::cout << "warning: if update_threhsold is larger than n, the algorithm will finish in 0 round."<< std::endl;
   }
 
-  auto clusters = parlay::sequence<gbbs::uintE>::from_function(n, [&] (size_t i) { return i; });
+  ASSIGN_OR_RETURN(auto seed, ReadSeedLabels(labelprop_config, n));
+  auto clusters = InitialLabels(seed, n);
+  auto is_pinned = parlay::sequence<bool>::from_function(n, [&] (size_t i) {
+    return pin_seed_labels && !seed.empty() && seed[i] != gbbs::UINT_E_MAX;
+  });
 
-  auto new_clusters = parlay::sequence<gbbs::uintE>();
-  if(!async){
-    new_clusters.resize(n);
+  // The frontier holds the vertices whose label may change this round, i.e.
+  // the neighbors of the vertices updated in the previous round. edgeMap
+  // switches between sparse and dense traversal depending on its size, so
+  // late rounds only touch the few vertices that are still moving.
+  parlay::sequence<gbbs::uintE> initial_nodes;
+  if (seed.empty()) {
+    initial_nodes = parlay::sequence<gbbs::uintE>::from_function(n, [&] (size_t i) { return i; });
+  } else if (labelprop_config.initial_active_nodes_size() > 0) {
+    // A warm start from a converged clustering only needs to revisit the
+    // nodes whose neighborhood changed since.
+    const auto& nodes = labelprop_config.initial_active_nodes();
+    if (std::any_of(nodes.begin(), nodes.end(), [&] (gbbs::uintE v) { return v >= n; })) {
+      return absl::InvalidArgumentError("initial_active_nodes contains a node id larger than the graph");
+    }
+    initial_nodes = parlay::unique(parlay::sort(parlay::filter(
+        parlay::sequence<gbbs::uintE>(nodes.begin(), nodes.end()),
+        [&] (gbbs::uintE v) { return !is_pinned[v]; })));
+  } else {
+    // A node whose neighbors all share its label keeps that label, so only
+    // nodes on a cluster boundary can move in the first round.
+    initial_nodes = parlay::pack_index<gbbs::uintE>(parlay::delayed_seq<bool>(n, [&] (size_t i) {
+      if (is_pinned[i]) return false;
+      auto differs_f = [&] (const auto& u, const auto& v, const auto& wgh) {
+        return clusters[v] != clusters[u];
+      };
+      return graph_.Graph()->get_vertex(i).out_neighbors().count(differs_f) > 0;
+    }));
   }
+  gbbs::vertexSubset active_nodes(n, std::move(initial_nodes));
+  auto is_active = parlay::sequence<bool>(n, false);
 
-  const auto all_nodes = parlay::sequence<gbbs::uintE>::from_function(n, [&] (size_t i) { return i; });
-  auto active_nodes = parlay::sequence<gbbs::uintE>::from_function(n, [&] (size_t i) { return i; });
-  auto is_active = parlay::sequence<bool>(n);
-  
   int n_iterations = 0; // number of iterations
-  std::atomic<int> n_update;
-  n_update.store(n);
+  std::size_t n_update = n;
 
   // propagate labels as long as a label has changed... or maximum iterations reached
-  while ((n_update > update_threshold) && (n_iterations < max_iteration)) {
-    // std::cout << "num iterations " << n_iterations << "\n";
+  while ((n_update > static_cast<std::size_t>(update_threshold)) && (n_iterations < max_iteration)) {
     n_iterations += 1;
 
-    // reset updated
-    n_update = 0;
-
-    auto table_size = async ? 0 :  active_nodes.size();
-    auto round_updates = parlay::hashtable<parlay::hash_numeric<gbbs::uintE>>(table_size, parlay::hash_numeric<gbbs::uintE>());
+    active_nodes.toSparse();
+    std::size_t num_active = active_nodes.size();
+    // New label and update flag of the i-th frontier vertex.
+    auto new_labels = parlay::sequence<gbbs::uintE>::uninitialized(num_active);
+    auto is_updated = parlay::sequence<bool>(num_active, false);
 
-    parlay::parallel_for(0, active_nodes.size(), [&] (size_t i) {
-      auto node_id = active_nodes[i];
-      is_active[node_id] = false;
-      });
+    parlay::parallel_for(0, num_active, [&] (size_t i) {
+      auto node_id = active_nodes.vtx(i);
 
-    parlay::parallel_for(0, active_nodes.size(), [&] (size_t i) {
-      auto node_id = active_nodes[i];
-
-      // std::cout << "Node " << node_id << std::endl;
       auto degree =  graph_.Graph()->get_vertex(node_id).out_degree();
       gbbs::uintE heaviest;
       if(degree == 0){
           heaviest = node_id;
-      } else {
-      // } else if(degree < par_threshold){
+      } else if(degree < par_threshold){
           // neighborLabelCounts maps label -> frequency in the neighbors
           std::map<gbbs::uintE, double> label_weights_sum;
           auto map_f = [&] (const auto& u, const auto& v, const auto& wgh) {
@@ -91,60 +222,45 @@ std::cout << "async: " << async << std::endl;
           };
           graph_.Graph()->get_vertex(node_id).out_neighbors().map(map_f, false);
 
-          // for(auto [v, w]: label_weights_sum){
-          //   std::cout << v << " " << w << "\n";
-          // }
-
-          heaviest = std::max_element(label_weights_sum.begin(), label_weights_sum.end(),
-                                                  [](const std::pair<gbbs::uintE, double> &p1,
-                                                    const std::pair<gbbs::uintE, double> &p2) {
-                                                      return p1.second < p2.second || (p1.second == p2.second && p1.first < p2.first);
-                                                  })
-                                    ->first;
-      // } else {
-      //   auto neighbors = graph_.Graph()->get_vertex(node_id).out_neighbors();
-
-      //   auto label_weights = parlay::delayed_seq<std::pair<gbbs::uintE, double>>(degree, [&](size_t i){
-      //     auto [v, w] = neighbors.get_ith_neighbor(i);
-      //     return std::make_pair(clusters[v], w);
-      //   });
-
-      //   auto grouped = parlay::group_by_key(label_weights);
-      //   auto label_weights_sum = parlay::sequence<std::pair<double, gbbs::uintE>>(grouped.size());
-      //   parlay::parallel_for(0, grouped.size(), [&](gbbs::uintE i){
-      //     auto cluster_id = grouped[i].first;
-      //     auto w = parlay::reduce(grouped[i].second);
-      //     label_weights_sum[i] = {w, cluster_id};
-      //   });
-
-      //   heaviest = parlay::max_element(label_weights_sum)->second;
+          heaviest = HeaviestLabel(label_weights_sum);
+      } else {
+        // High-degree vertex: sum the neighbor weights per label with a
+        // parallel reduction instead of a sequential map.
+        auto label_weights = parlay::sequence<std::pair<gbbs::uintE, double>>::uninitialized(degree);
+        auto map_f = [&] (const auto& u, const auto& v, const auto& wgh, const auto& j) {
+          label_weights[j] = std::make_pair(clusters[v], static_cast<double>(wgh));
+        };
+        graph_.Graph()->get_vertex(node_id).out_neighbors().map_with_index(map_f);
+        heaviest = HeaviestLabel(parlay::reduce_by_key(label_weights));
       }
 
       // A can only change in the next round if any of its neighbors change label.
       if (clusters[node_id] != heaviest) { // UPDATE
+        new_labels[i] = heaviest;
+        is_updated[i] = true;
         if(async){
           clusters[node_id] = heaviest;
-        } else {
-          new_clusters[node_id] = heaviest;
-          round_updates.insert(node_id);
         }
-          n_update.fetch_add(1);
-          auto activate_f = [&] (const auto& u, const auto& v, const auto& wgh) {
-            if(!is_active[v]) is_active[v] = true; 
-          };
-          graph_.Graph()->get_vertex(node_id).out_neighbors().map(activate_f);
-      } 
+      }
     });
 
+    auto updated_ids = parlay::pack(
+        parlay::delayed_seq<gbbs::uintE>(num_active, [&] (size_t i) { return active_nodes.vtx(i); }),
+        is_updated);
+    n_update = updated_ids.size();
+
     if(!async){
-      auto updates = round_updates.entries();
-      parlay::parallel_for(0, n_update, [&](std::size_t i){
-        auto node_id = updates[i];
-        clusters[node_id] = new_clusters[node_id];
+      parlay::parallel_for(0, num_active, [&](std::size_t i){
+        if (is_updated[i]) clusters[active_nodes.vtx(i)] = new_labels[i];
       });
     }
 
-    active_nodes = parlay::pack(all_nodes, is_active);
+    gbbs::vertexSubset updated(n, std::move(updated_ids));
+    active_nodes = gbbs::edgeMap(*graph_.Graph(), updated, ActivateNeighbors(is_active.begin(), is_pinned.begin()));
+    active_nodes.toSparse();
+    parlay::parallel_for(0, active_nodes.size(), [&] (size_t i) {
+      is_active[active_nodes.vtx(i)] = false;
+    });
 
     } // end while
 
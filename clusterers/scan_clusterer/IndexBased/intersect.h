@@ -237,6 +237,36 @@ typename IntersectReturn<Weight>::type intersect_f_with_index_par(
   }
 }
 
+// Same as the unweighted case of `intersect_f_with_index_par`, but also
+// accepts weighted vertices, whose edge weights are ignored. Returns the number
+// of shared neighbors between `A` and `B` and runs
+// `f(c, a_to_c_index, b_to_c_index)` for each shared neighbor c.
+template <template <typename> class VertexTemplate, typename Weight, class F>
+size_t intersect_structure_f_with_index_par(VertexTemplate<Weight>* A,
+                                            VertexTemplate<Weight>* B,
+                                            const F& f) {
+  if
+    constexpr(
+        std::is_same<VertexTemplate<Weight>, symmetric_vertex<Weight>>::value) {
+      using Neighbor = typename VertexTemplate<Weight>::edge_type;
+      const auto seqA{
+          gbbs::make_slice<Neighbor>(A->neighbors, A->out_degree())};
+      const auto seqB{
+          gbbs::make_slice<Neighbor>(B->neighbors, B->out_degree())};
+      constexpr size_t kOffset{0};
+      constexpr bool kAreSeqsSwapped{false};
+      // Merging as if unweighted only compares the neighbor IDs.
+      return scan::internal::merge<gbbs::empty>(seqA, seqB, kOffset, kOffset,
+                                                kAreSeqsSwapped, f);
+    }
+  else {
+    ABORT("Not yet implemented for compressed vertices");
+    (void)A;
+    (void)B;
+    (void)f;
+  }
+}
+
 }  // namespace internal
 
 }  // namespace scan
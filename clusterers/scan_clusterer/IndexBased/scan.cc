@@ -1,6 +1,12 @@
 #include "clusterers/scan_clusterer/IndexBased/scan.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <algorithm>
+#include <fstream>
 #include <tuple>
 #include <utility>
 
@@ -175,15 +181,192 @@ void AttachNoncoresToClustersDeterministic(
   internal::ReportTime(function_timer);
 }
 
+// Index file layout: an `IndexFileHeader` followed by, each starting at a
+// multiple of 8 bytes,
+//   uint64_t vertex_offsets[num_vertices + 1]
+//   EdgeSimilarity similarities[num_similarities]
+//   uint64_t core_offsets[num_core_offsets]
+//   CoreThreshold core_thresholds[num_core_thresholds]
+// in native byte order. `vertex_offsets` delimits the similarities of each
+// vertex, and the precomputed part of the core order is stored as by
+// `CoreOrder::FirstMu()`, `CoreOrder::Offsets()` and `CoreOrder::Thresholds()`.
+struct IndexFileHeader {
+  uint64_t magic;
+  uint64_t version;
+  uint64_t fingerprint;
+  uint64_t num_vertices;
+  uint64_t num_similarities;
+  uint64_t max_mu;
+  uint64_t first_mu;
+  uint64_t num_core_offsets;
+  uint64_t num_core_thresholds;
+};
+
+constexpr uint64_t kIndexFileMagic{0x5844494e41435353};  // "SSCANIDX"
+constexpr uint64_t kIndexFileVersion{2};
+
+// Rounds `bytes` up to a multiple of 8.
+size_t Align(const size_t bytes) { return (bytes + 7) & ~size_t{7}; }
+
+// Byte offsets of the arrays of an index file with header `header`.
+struct IndexFileLayout {
+  explicit IndexFileLayout(const IndexFileHeader& header)
+      : vertex_offsets{Align(sizeof(IndexFileHeader))},
+        similarities{Align(vertex_offsets +
+                           (header.num_vertices + 1) * sizeof(uint64_t))},
+        core_offsets{Align(similarities +
+                           header.num_similarities *
+                               sizeof(internal::EdgeSimilarity))},
+        core_thresholds{
+            Align(core_offsets + header.num_core_offsets * sizeof(uint64_t))},
+        file_size{core_thresholds + header.num_core_thresholds *
+                                        sizeof(internal::CoreThreshold)} {}
+
+  size_t vertex_offsets;
+  size_t similarities;
+  size_t core_offsets;
+  size_t core_thresholds;
+  size_t file_size;
+};
+
+// Writes `num_bytes` bytes from `data` to `file` at byte offset `position`,
+// zero-padding from the current end of the file.
+void WriteAt(std::ofstream* file, const size_t position, const void* data,
+             const size_t num_bytes) {
+  const size_t current{static_cast<size_t>(file->tellp())};
+  for (size_t i = current; i < position; i++) {
+    file->put('\0');
+  }
+  file->write(static_cast<const char*>(data), num_bytes);
+}
+
 }  // namespace
 
 Index::Index()
     : num_vertices_{0U}, neighbor_order_{}, core_order_{neighbor_order_} {}
 
+Index::Index(const size_t num_vertices,
+             internal::NeighborOrder&& neighbor_order,
+             internal::CoreOrder&& core_order,
+             std::shared_ptr<const void> storage)
+    : num_vertices_{num_vertices},
+      neighbor_order_{std::move(neighbor_order)},
+      core_order_{std::move(core_order)},
+      storage_{std::move(storage)} {}
+
+bool Index::Save(const std::string& filename,
+                 const uint64_t fingerprint) const {
+  timer function_timer{"Save index"};
+  const auto similarities{neighbor_order_.AllSimilarities()};
+  const auto core_offsets{core_order_.Offsets()};
+  const auto core_thresholds{core_order_.Thresholds()};
+  const IndexFileHeader header{.magic = kIndexFileMagic,
+                               .version = kIndexFileVersion,
+                               .fingerprint = fingerprint,
+                               .num_vertices = num_vertices_,
+                               .num_similarities = similarities.size(),
+                               .max_mu = core_order_.MaxMu(),
+                               .first_mu = core_order_.FirstMu(),
+                               .num_core_offsets = core_offsets.size(),
+                               .num_core_thresholds = core_thresholds.size()};
+  const IndexFileLayout layout{header};
+  const sequence<uint64_t> vertex_offsets{
+      sequence<uint64_t>::from_function(num_vertices_ + 1, [&](const size_t i) {
+        return i == num_vertices_
+                   ? similarities.size()
+                   : static_cast<size_t>(neighbor_order_[i].begin() -
+                                         similarities.begin());
+      })};
+
+  std::ofstream file{filename, std::ios::binary | std::ios::trunc};
+  if (!file.is_open()) {
+    return false;
+  }
+  WriteAt(&file, 0, &header, sizeof(header));
+  WriteAt(&file, layout.vertex_offsets, vertex_offsets.begin(),
+          vertex_offsets.size() * sizeof(uint64_t));
+  WriteAt(&file, layout.similarities, similarities.begin(),
+          similarities.size() * sizeof(internal::EdgeSimilarity));
+  WriteAt(&file, layout.core_offsets, core_offsets.begin(),
+          core_offsets.size() * sizeof(uint64_t));
+  WriteAt(&file, layout.core_thresholds, core_thresholds.begin(),
+          core_thresholds.size() * sizeof(internal::CoreThreshold));
+  file.close();
+  internal::ReportTime(function_timer);
+  return !file.fail();
+}
+
+std::unique_ptr<Index> Index::Load(const std::string& filename,
+                                   const uint64_t fingerprint,
+                                   const size_t core_order_max_bytes) {
+  const int fd{open(filename.c_str(), O_RDONLY)};
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 ||
+      static_cast<size_t>(file_stat.st_size) < sizeof(IndexFileHeader)) {
+    close(fd);
+    return nullptr;
+  }
+  const size_t file_size{static_cast<size_t>(file_stat.st_size)};
+  void* const data{mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0)};
+  close(fd);
+  if (data == MAP_FAILED) {
+    return nullptr;
+  }
+  std::shared_ptr<const void> storage{
+      data, [file_size](const void* p) {
+        munmap(const_cast<void*>(p), file_size);
+      }};
+
+  const IndexFileHeader& header{*static_cast<const IndexFileHeader*>(data)};
+  if (header.magic != kIndexFileMagic ||
+      header.version != kIndexFileVersion ||
+      header.fingerprint != fingerprint ||
+      IndexFileLayout{header}.file_size != file_size) {
+    return nullptr;
+  }
+  const IndexFileLayout layout{header};
+  // The mapping is read-only; the mutable pointers are only needed to build
+  // slices and are never written through.
+  char* const bytes{static_cast<char*>(data)};
+  const auto vertex_offsets{gbbs::make_slice<uint64_t>(
+      reinterpret_cast<uint64_t*>(bytes + layout.vertex_offsets),
+      header.num_vertices + 1)};
+  if (vertex_offsets[header.num_vertices] != header.num_similarities) {
+    return nullptr;
+  }
+  internal::NeighborOrder neighbor_order{
+      gbbs::make_slice<internal::EdgeSimilarity>(
+          reinterpret_cast<internal::EdgeSimilarity*>(bytes +
+                                                      layout.similarities),
+          header.num_similarities),
+      vertex_offsets};
+  const auto* const core_thresholds{
+      reinterpret_cast<const internal::CoreThreshold*>(bytes +
+                                                       layout.core_thresholds)};
+  const auto* const core_offsets{
+      reinterpret_cast<const uint64_t*>(bytes + layout.core_offsets)};
+  internal::CoreOrder core_order{
+      header.num_vertices,
+      header.max_mu,
+      header.first_mu,
+      gbbs::slice<const internal::CoreThreshold>(
+          core_thresholds, core_thresholds + header.num_core_thresholds),
+      gbbs::slice<const uint64_t>(core_offsets,
+                                  core_offsets + header.num_core_offsets),
+      core_order_max_bytes};
+  return std::unique_ptr<Index>{new Index{
+      header.num_vertices, std::move(neighbor_order), std::move(core_order),
+      std::move(storage)}};
+}
+
 Clustering Index::Cluster(const uint64_t mu, const float epsilon,
                           const bool get_deterministic_result) const {
   timer preprocessing_timer{"Cluster - additional preprocessing time"};
-  const sequence<uintE> cores{core_order_.GetCores(mu, epsilon)};
+  const sequence<uintE> cores{
+      core_order_.GetCores(neighbor_order_, mu, epsilon)};
   if (cores.empty()) {
     // Nothing is a core. There are no clusters, and every vertex is an outlier.
     return Clustering(num_vertices_, kUnclustered);
@@ -228,6 +411,10 @@ void Index::Cluster(const uint64_t mu, const sequence<float>& epsilons,
                                 return epsilons[i] > epsilons[j];
                               });
 
+  // The cores of every epsilon are read off the same order, so each one
+  // extends those of the previous, larger epsilon.
+  const internal::MuCoreOrder mu_core_order{
+      core_order_.ForMu(neighbor_order_, mu)};
   sequence<uintE> previous_cores{};
   sequence<uintE> previous_core_similar_edge_counts{};
   VertexSet cores_set{MakeVertexSet(num_vertices_)};
@@ -237,7 +424,7 @@ void Index::Cluster(const uint64_t mu, const sequence<float>& epsilons,
     const float epsilon{epsilons[sorted_epsilon_indices[i]]};
     Clustering clustering{std::move(previous_core_clustering)};
 
-    sequence<uintE> cores{core_order_.GetCores(mu, epsilon)};
+    sequence<uintE> cores{mu_core_order.GetCores(epsilon)};
     sequence<uintE> core_similar_edge_counts{
         parlay::map<uintE>(cores, [&](const uintE vertex) {
           // Get the number of neighbors of `vertex` that have at least
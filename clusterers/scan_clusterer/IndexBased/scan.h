@@ -1,5 +1,9 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <string>
+
 #include "clusterers/scan_clusterer/IndexBased/scan_helpers.h"
 #include "clusterers/scan_clusterer/IndexBased/similarity_measure.h"
 #include "clusterers/scan_clusterer/IndexBased/utils.h"
@@ -11,6 +15,7 @@ namespace indexed_scan {
 
 using scan::Clustering;
 using scan::kUnclustered;
+using CoreOrderOptions = internal::CoreOrderOptions;
 
 // Index for an undirected graph from which clustering the graph with SCAN is
 // quick, though index construction may be expensive.
@@ -25,17 +30,40 @@ class Index {
   //   similarity_measure: similarity measure from `similarity_measure.h`
   //     Determines how to compute the similarity between two adjacency
   //     vertices. The traditional choice for SCAN is `scan::CosineSimilarity`.
+  //   core_order_options
+  //     Which values of SCAN parameter mu to precompute core vertices for, and
+  //     a memory bound on them. Clustering with any other mu is still
+  //     supported but first spends time comparable to a single-mu index
+  //     construction.
   template <class Graph,
             class SimilarityMeasure = scan::CosineSimilarity>
   explicit Index(
       Graph* graph,
-      const SimilarityMeasure& similarity_measure = scan::CosineSimilarity{})
+      const SimilarityMeasure& similarity_measure = scan::CosineSimilarity{},
+      const CoreOrderOptions& core_order_options = {})
       : num_vertices_{graph->n},
         neighbor_order_{graph, similarity_measure},
-        core_order_{neighbor_order_} {}
+        core_order_{neighbor_order_, core_order_options} {}
 
   Index();
 
+  // Writes the index to the binary file `filename`, tagged with `fingerprint`,
+  // which should identify the graph and similarity measure the index was built
+  // from (see `scan::GraphFingerprint`). Returns false on I/O failure.
+  bool Save(const std::string& filename, uint64_t fingerprint) const;
+
+  // Maps an index written by `Save` into memory. The file is not copied, so
+  // processes loading the same file share its pages. Returns nullptr if the
+  // file cannot be read, is not an index file, or has a fingerprint other than
+  // `fingerprint`.
+  //
+  // Core vertices for values of mu that were not precomputed in the file are
+  // computed on first use and cached up to `core_order_max_bytes` (0 for no
+  // bound).
+  static std::unique_ptr<Index> Load(const std::string& filename,
+                                     uint64_t fingerprint,
+                                     size_t core_order_max_bytes = 0);
+
   // Compute a SCAN clustering of the indexed graph using SCAN parameters
   // mu and epsilon.
   //
@@ -79,9 +107,14 @@ class Index {
                bool get_deterministic_result = false) const;
 
  private:
+  Index(size_t num_vertices, internal::NeighborOrder&& neighbor_order,
+        internal::CoreOrder&& core_order, std::shared_ptr<const void> storage);
+
   size_t num_vertices_;
   internal::NeighborOrder neighbor_order_;
   internal::CoreOrder core_order_;
+  // Keeps the mapped file of a loaded index alive. Null for built indices.
+  std::shared_ptr<const void> storage_{};
 };
 
 }  // namespace indexed_scan
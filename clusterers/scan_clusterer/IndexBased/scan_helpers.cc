@@ -1,5 +1,6 @@
 #include "clusterers/scan_clusterer/IndexBased/scan_helpers.h"
 
+#include <algorithm>
 #include <limits>
 
 namespace gbbs {
@@ -32,6 +33,17 @@ void ReportTime([[maybe_unused]] const timer& t) {
 
 NeighborOrder::NeighborOrder() : similarities_{}, similarities_by_source_{} {}
 
+NeighborOrder::NeighborOrder(gbbs::slice<EdgeSimilarity> similarities,
+                             gbbs::slice<uint64_t> vertex_offsets)
+    : similarities_{},
+      similarities_by_source_{
+          sequence<gbbs::slice<EdgeSimilarity>>::from_function(
+              std::max<size_t>(vertex_offsets.size(), 1) - 1,
+              [&](const size_t i) {
+                return similarities.cut(vertex_offsets[i],
+                                        vertex_offsets[i + 1]);
+              })} {}
+
 const gbbs::slice<EdgeSimilarity>& NeighborOrder::operator[](
     size_t source) const {
   return similarities_by_source_[source];
@@ -49,10 +61,71 @@ const gbbs::slice<EdgeSimilarity>* NeighborOrder::end() const {
   return similarities_by_source_.end();
 }
 
-sequence<sequence<CoreThreshold>> ComputeCoreOrder(
-    const NeighborOrder& neighbor_order) {
+gbbs::slice<EdgeSimilarity> NeighborOrder::AllSimilarities() const {
+  if (empty()) {
+    return gbbs::slice<EdgeSimilarity>(nullptr, nullptr);
+  }
+  return gbbs::slice<EdgeSimilarity>(similarities_by_source_[0].begin(),
+                                     similarities_by_source_[size() - 1].end());
+}
+
+namespace {
+
+// Sorts `core_thresholds` by descending threshold and then by ascending vertex
+// ID. Breaking ties makes the order the same on every computation, which
+// `Index::Cluster` relies on when it grows the cores of several epsilons.
+void SortCoreThresholds(gbbs::slice<CoreThreshold> core_thresholds) {
+  parlay::sample_sort_inplace(
+      core_thresholds, [](const CoreThreshold& a, const CoreThreshold& b) {
+        return a.threshold > b.threshold ||
+               (a.threshold == b.threshold && a.vertex_id < b.vertex_id);
+      });
+}
+
+}  // namespace
+
+MuCoreOrder::MuCoreOrder(
+    const gbbs::slice<const CoreThreshold> thresholds,
+    std::shared_ptr<const sequence<CoreThreshold>> storage)
+    : thresholds_{thresholds}, storage_{std::move(storage)} {}
+
+sequence<uintE> MuCoreOrder::GetCores(const float epsilon) const {
+  const size_t cores_end{parlay::binary_search(
+      thresholds_, [epsilon](const CoreThreshold& core_threshold) {
+        return core_threshold.threshold >= epsilon;
+      })};
+  return parlay::map<uintE>(
+      thresholds_.cut(0, cores_end),
+      [](const CoreThreshold& core_threshold) {
+        return core_threshold.vertex_id;
+      });
+}
+
+sequence<CoreThreshold> ComputeCoreThresholds(
+    const NeighborOrder& neighbor_order, const uint64_t mu) {
+  // Only vertices with high enough degree can be cores.
+  const sequence<uintE> core_vertices{
+      parlay::pack_index<uintE>(parlay::delayed_seq<bool>(
+          neighbor_order.size(),
+          [&](const size_t v) { return neighbor_order[v].size() + 1 >= mu; }))};
+  sequence<CoreThreshold> core_thresholds{
+      parlay::map<CoreThreshold>(core_vertices, [&](const uintE vertex_id) {
+        return CoreThreshold{
+            .vertex_id = vertex_id,
+            .threshold = neighbor_order[vertex_id][mu - 2].similarity};
+      })};
+  SortCoreThresholds(make_slice(core_thresholds));
+  return core_thresholds;
+}
+
+CoreOrder::CoreOrder(const NeighborOrder& neighbor_order,
+                     const CoreOrderOptions& options)
+    : num_vertices_{neighbor_order.size()} {
+  if (options.max_bytes > 0) {
+    cache_capacity_ = options.max_bytes;
+  }
   if (neighbor_order.empty()) {
-    return {};
+    return;
   }
 
   timer function_timer{"Compute core order time"};
@@ -68,6 +141,14 @@ sequence<sequence<CoreThreshold>> ComputeCoreOrder(
       make_slice(vertex_degrees),
       [](const VertexDegree& vertex_degree) { return vertex_degree.degree; });
   const size_t max_degree{vertex_degrees[vertex_degrees.size() - 1].degree};
+  max_mu_ = max_degree + 1;
+
+  first_mu_ = std::max<uint64_t>(options.min_mu, 2);
+  const uint64_t last_mu{std::min<uint64_t>(options.max_mu, max_mu_)};
+  if (first_mu_ > last_mu) {  // Nothing to precompute.
+    internal::ReportTime(function_timer);
+    return;
+  }
 
   // `degree_offsets[j]` is the first index `i` at which
   // `vertex_degrees[i].degree >= j`.
@@ -85,62 +166,139 @@ sequence<sequence<CoreThreshold>> ComputeCoreOrder(
     }
   });
 
-  const auto get_core_order{[&](const size_t mu) {
-    if (mu <= 1) {
-      return sequence<CoreThreshold>{};
+  // The order for mu holds the vertices of degree at least mu - 1, so orders
+  // shrink as mu grows. The exclusive scan leaves the total in the last entry.
+  const size_t num_orders{last_mu - first_mu_ + 1};
+  offsets_ = sequence<uint64_t>::from_function(
+      num_orders + 1, [&](const size_t i) -> uint64_t {
+        return i == num_orders
+                   ? 0
+                   : vertex_degrees.size() - degree_offsets[first_mu_ + i - 1];
+      });
+  parlay::scan_inplace(offsets_);
+  if (options.max_bytes > 0) {
+    // Keep the longest prefix of the range that fits in the budget.
+    const size_t max_thresholds{options.max_bytes / sizeof(CoreThreshold)};
+    const size_t num_kept_offsets{parlay::binary_search(
+        offsets_,
+        [&](const uint64_t offset) { return offset <= max_thresholds; })};
+    if (num_kept_offsets < offsets_.size()) {
+      offsets_ = sequence<uint64_t>(offsets_.begin(),
+                                    offsets_.begin() + num_kept_offsets);
     }
+    cache_capacity_ = options.max_bytes -
+                      offsets_[offsets_.size() - 1] * sizeof(CoreThreshold);
+  }
 
-    // Only vertices with high enough degree can be cores.
+  thresholds_ =
+      sequence<CoreThreshold>::uninitialized(offsets_[offsets_.size() - 1]);
+  parallel_for(0, offsets_.size() - 1, [&](const size_t i) {
+    const uint64_t mu{first_mu_ + i};
     auto core_vertices =
         vertex_degrees.cut(degree_offsets[mu - 1], vertex_degrees.size());
-
-    sequence<CoreThreshold> core_thresholds{parlay::map<CoreThreshold>(
-        core_vertices, [&](const VertexDegree& vertex_degree) {
-          return CoreThreshold{
-              .vertex_id = vertex_degree.vertex_id,
-              .threshold =
-                  neighbor_order[vertex_degree.vertex_id][mu - 2].similarity};
-        })};
-    // Sort by descending threshold.
-    const auto compare_threshold_descending{
-        [](const CoreThreshold& a, const CoreThreshold& b) {
-          return a.threshold > b.threshold;
-        }};
-    parlay::sample_sort_inplace(make_slice(core_thresholds),
-                                compare_threshold_descending);
-    return core_thresholds;
-  }};
-
-  auto core_order = sequence<sequence<CoreThreshold>>::from_function(
-      max_degree + 2, get_core_order);
+    auto core_thresholds = thresholds_.cut(offsets_[i], offsets_[i + 1]);
+    parallel_for(0, core_vertices.size(), [&](const size_t j) {
+      const uintE vertex_id{core_vertices[j].vertex_id};
+      core_thresholds[j] = CoreThreshold{
+          .vertex_id = vertex_id,
+          .threshold = neighbor_order[vertex_id][mu - 2].similarity};
+    });
+    SortCoreThresholds(core_thresholds);
+  }, 1);
 
   internal::ReportTime(function_timer);
-  return core_order;
 }
 
-CoreOrder::CoreOrder(const NeighborOrder& neighbor_order)
-    : num_vertices_{neighbor_order.size()},
-      order_{ComputeCoreOrder(neighbor_order)} {}
+CoreOrder::CoreOrder(const size_t num_vertices, const uint64_t max_mu,
+                     const uint64_t first_mu,
+                     gbbs::slice<const CoreThreshold> thresholds,
+                     gbbs::slice<const uint64_t> offsets,
+                     const size_t max_bytes)
+    : num_vertices_{num_vertices},
+      max_mu_{max_mu},
+      first_mu_{first_mu},
+      external_thresholds_{thresholds.begin()},
+      external_offsets_{offsets.begin()},
+      num_external_thresholds_{thresholds.size()},
+      num_external_offsets_{offsets.size()} {
+  if (max_bytes > 0) {
+    cache_capacity_ = max_bytes;
+  }
+}
+
+uint64_t CoreOrder::MaxMu() const { return max_mu_; }
+
+uint64_t CoreOrder::FirstMu() const { return first_mu_; }
+
+gbbs::slice<const CoreThreshold> CoreOrder::Thresholds() const {
+  if (external_offsets_ != nullptr) {
+    return gbbs::slice<const CoreThreshold>(
+        external_thresholds_, external_thresholds_ + num_external_thresholds_);
+  }
+  return gbbs::slice<const CoreThreshold>(thresholds_.begin(),
+                                          thresholds_.end());
+}
+
+gbbs::slice<const uint64_t> CoreOrder::Offsets() const {
+  if (external_offsets_ != nullptr) {
+    return gbbs::slice<const uint64_t>(
+        external_offsets_, external_offsets_ + num_external_offsets_);
+  }
+  return gbbs::slice<const uint64_t>(offsets_.begin(), offsets_.end());
+}
 
-sequence<uintE> CoreOrder::GetCores(const uint64_t mu,
+sequence<uintE> CoreOrder::GetCores(const NeighborOrder& neighbor_order,
+                                    const uint64_t mu,
                                     const float epsilon) const {
+  return ForMu(neighbor_order, mu).GetCores(epsilon);
+}
+
+MuCoreOrder CoreOrder::ForMu(const NeighborOrder& neighbor_order,
+                             const uint64_t mu) const {
   if (mu <= 1) {  // All vertices are cores.
-    return sequence<uintE>::from_function(num_vertices_,
-                                          [](const size_t i) { return i; });
+    auto all_cores{std::make_shared<const sequence<CoreThreshold>>(
+        sequence<CoreThreshold>::from_function(
+            num_vertices_, [](const size_t i) {
+              return CoreThreshold{
+                  .vertex_id = static_cast<uintE>(i),
+                  .threshold = std::numeric_limits<float>::infinity()};
+            }))};
+    return MuCoreOrder{gbbs::slice<const CoreThreshold>(all_cores->begin(),
+                                                        all_cores->end()),
+                       all_cores};
   }
-  if (mu >= order_.size()) {  // No vertices are cores.
-    return {};
+  if (mu > max_mu_) {  // No vertices are cores.
+    return MuCoreOrder{gbbs::slice<const CoreThreshold>(nullptr, nullptr),
+                       nullptr};
   }
 
-  const sequence<CoreThreshold>& possible_cores(order_[mu]);
-  const size_t cores_end{parlay::binary_search(
-      possible_cores, [epsilon](const internal::CoreThreshold& core_threshold) {
-        return core_threshold.threshold >= epsilon;
-      })};
-  return parlay::map<uintE>(possible_cores.cut(0, cores_end),
-                            [](const internal::CoreThreshold& core_threshold) {
-                              return core_threshold.vertex_id;
-                            });
+  const auto offsets = Offsets();
+  if (mu >= first_mu_ && mu - first_mu_ + 1 < offsets.size()) {
+    const size_t i{mu - first_mu_};
+    return MuCoreOrder{Thresholds().cut(offsets[i], offsets[i + 1]), nullptr};
+  }
+
+  std::shared_ptr<const sequence<CoreThreshold>> core_thresholds;
+  {
+    std::lock_guard<std::mutex> lock{cache_->mutex};
+    const auto it{cache_->orders.find(mu)};
+    if (it != cache_->orders.end()) {
+      core_thresholds = it->second;
+    }
+  }
+  if (core_thresholds == nullptr) {
+    core_thresholds = std::make_shared<const sequence<CoreThreshold>>(
+        ComputeCoreThresholds(neighbor_order, mu));
+    const size_t num_bytes{core_thresholds->size() * sizeof(CoreThreshold)};
+    std::lock_guard<std::mutex> lock{cache_->mutex};
+    if (cache_->num_bytes + num_bytes <= cache_capacity_ &&
+        cache_->orders.emplace(mu, core_thresholds).second) {
+      cache_->num_bytes += num_bytes;
+    }
+  }
+  return MuCoreOrder{gbbs::slice<const CoreThreshold>(core_thresholds->begin(),
+                                                      core_thresholds->end()),
+                     core_thresholds};
 }
 
 }  // namespace internal
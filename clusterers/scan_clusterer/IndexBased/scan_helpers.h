@@ -4,6 +4,11 @@
 // main SCAN header file.
 #pragma once
 
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <utility>
 
 #include "clusterers/scan_clusterer/IndexBased/similarity_measure.h"
@@ -33,6 +38,13 @@ class NeighborOrder {
 
   NeighborOrder();
 
+  // Constructor over similarity scores stored elsewhere, e.g. in a mapped index
+  // file, which must outlive this object. `similarities` is sorted as in
+  // `AllSimilarities()`, and the similarities of vertex i are
+  // `similarities[vertex_offsets[i], vertex_offsets[i + 1])`.
+  NeighborOrder(gbbs::slice<EdgeSimilarity> similarities,
+                gbbs::slice<uint64_t> vertex_offsets);
+
   // Get all similarity scores from vertex `source` to its neighbors (not
   // including `source` itself), sorted by descending similarity.
   const gbbs::slice<EdgeSimilarity>& operator[](size_t source) const;
@@ -44,9 +56,13 @@ class NeighborOrder {
   const gbbs::slice<EdgeSimilarity>* begin() const;
   const gbbs::slice<EdgeSimilarity>* end() const;
 
+  // Get the similarity scores of all vertices, sorted by source and then by
+  // descending similarity.
+  gbbs::slice<EdgeSimilarity> AllSimilarities() const;
+
  private:
   // Holds similarity scores for all edges, sorted by source and then by
-  // similarity.
+  // similarity. Empty if the scores are stored elsewhere.
   sequence<EdgeSimilarity> similarities_;
   sequence<gbbs::slice<EdgeSimilarity>> similarities_by_source_;
 };
@@ -59,17 +75,97 @@ struct CoreThreshold {
 };
 std::ostream& operator<<(std::ostream& os, const CoreThreshold&);
 
+// The core thresholds for a single value of SCAN parameter mu, sorted by
+// descending threshold and then by ascending vertex ID. Since the order is
+// total, the cores under a smaller epsilon always extend the cores under a
+// larger one.
+class MuCoreOrder {
+ public:
+  // Return all vertices that are cores under SCAN parameter `epsilon`.
+  sequence<uintE> GetCores(float epsilon) const;
+
+ private:
+  friend class CoreOrder;
+
+  MuCoreOrder(gbbs::slice<const CoreThreshold> thresholds,
+              std::shared_ptr<const sequence<CoreThreshold>> storage);
+
+  gbbs::slice<const CoreThreshold> thresholds_;
+  // Owns `thresholds_` unless they are part of a `CoreOrder`.
+  std::shared_ptr<const sequence<CoreThreshold>> storage_;
+};
+
+// Controls which parts of a `CoreOrder` are computed up front.
+struct CoreOrderOptions {
+  // Core thresholds are precomputed for mu in [min_mu, max_mu] and computed on
+  // first use for any other mu.
+  uint64_t min_mu{2};
+  uint64_t max_mu{std::numeric_limits<uint64_t>::max()};
+  // Bound on the bytes of core thresholds held in memory, or 0 for no bound.
+  // The precomputed range is cut short from above to fit, and thresholds
+  // computed on first use are only cached while they fit.
+  size_t max_bytes{0};
+};
+
 class CoreOrder {
  public:
-  explicit CoreOrder(const NeighborOrder& neighbor_order);
+  explicit CoreOrder(const NeighborOrder& neighbor_order,
+                     const CoreOrderOptions& options = {});
+
+  // Constructor over precomputed thresholds stored elsewhere, e.g. in a mapped
+  // index file, which must outlive this object. See `Thresholds()` and
+  // `Offsets()` for the layout. `max_bytes` bounds the thresholds cached for
+  // mu outside the stored range.
+  CoreOrder(size_t num_vertices, uint64_t max_mu, uint64_t first_mu,
+            gbbs::slice<const CoreThreshold> thresholds,
+            gbbs::slice<const uint64_t> offsets, size_t max_bytes = 0);
 
   // Return all vertices that are cores under SCAN parameters `mu` and
-  // `epsilon`.
-  sequence<uintE> GetCores(uint64_t mu, float epsilon) const;
+  // `epsilon`. `neighbor_order` must be the one this order was built from.
+  sequence<uintE> GetCores(const NeighborOrder& neighbor_order, uint64_t mu,
+                           float epsilon) const;
+
+  // Return the core thresholds under SCAN parameter `mu`, computing them if
+  // they were not precomputed, for clustering with several values of epsilon.
+  // `neighbor_order` must be the one this order was built from, and the result
+  // must not outlive this order.
+  MuCoreOrder ForMu(const NeighborOrder& neighbor_order, uint64_t mu) const;
+
+  // Largest mu under which any vertex can be a core, i.e. the maximum degree
+  // plus one.
+  uint64_t MaxMu() const;
+
+  // The precomputed thresholds are stored flat: the core thresholds for
+  // mu in [FirstMu(), FirstMu() + Offsets().size() - 1) are
+  // `Thresholds()[Offsets()[mu - FirstMu()], Offsets()[mu - FirstMu() + 1])`,
+  // sorted as in `MuCoreOrder`.
+  uint64_t FirstMu() const;
+  gbbs::slice<const CoreThreshold> Thresholds() const;
+  gbbs::slice<const uint64_t> Offsets() const;
 
  private:
+  // Thresholds computed on first use, keyed by mu.
+  struct Cache {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, std::shared_ptr<const sequence<CoreThreshold>>>
+        orders;
+    size_t num_bytes{0};
+  };
+
   size_t num_vertices_;
-  sequence<sequence<CoreThreshold>> order_{};
+  uint64_t max_mu_{0};
+  uint64_t first_mu_{2};
+  sequence<CoreThreshold> thresholds_{};
+  sequence<uint64_t> offsets_{};
+  // Set instead of `thresholds_` and `offsets_` if the order is stored
+  // elsewhere.
+  const CoreThreshold* external_thresholds_{nullptr};
+  const uint64_t* external_offsets_{nullptr};
+  size_t num_external_thresholds_{0};
+  size_t num_external_offsets_{0};
+  // Bytes available to `cache_`.
+  size_t cache_capacity_{std::numeric_limits<size_t>::max()};
+  std::unique_ptr<Cache> cache_{std::make_unique<Cache>()};
 };
 
 // Prints the total time captured by `timer` to stderr if macro
@@ -103,15 +199,12 @@ NeighborOrder::NeighborOrder(Graph* graph,
   internal::ReportTime(function_timer);
 }
 
-// Returns a sequence CO where CO[i] for i >= 2 is a list of vertices that
-// can be a core when the SCAN parameter mu is set to i. The vertices in
-// CO[i] are sorted by their core threshold values, the maximum value of SCAN
-// parameter epsilon such that the vertex is a core when mu == i.
-//
-// CO[0] and CO[1] are left empty --- when mu is less than 2, all vertices are
-// always cores and have a core threshold of 1.
-sequence<sequence<CoreThreshold>> ComputeCoreOrder(
-    const NeighborOrder& neighbor_order);
+// Returns the core thresholds for SCAN parameter mu >= 2: every vertex that
+// can be a core when mu is set to that value, with the maximum value of SCAN
+// parameter epsilon such that it is a core, sorted by descending threshold and
+// then by ascending vertex ID.
+sequence<CoreThreshold> ComputeCoreThresholds(
+    const NeighborOrder& neighbor_order, uint64_t mu);
 
 }  // namespace internal
 
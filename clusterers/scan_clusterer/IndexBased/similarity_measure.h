@@ -77,13 +77,46 @@ class CosineSimilarity {
 //   (size of union of the closed neighborhoods of u and of v)
 // where the closed neighborhood of a vertex x consists of all neighbors of x
 // along with x itself.
+//
+// Edge weights of weighted graphs are ignored.
 class JaccardSimilarity {
  public:
   JaccardSimilarity() = default;
 
-  template <template <typename> class VertexTemplate>
-  sequence<EdgeSimilarity> AllEdges(
-      symmetric_graph<VertexTemplate, gbbs::empty>* graph) const;
+  template <class Graph>
+  sequence<EdgeSimilarity> AllEdges(Graph* graph) const;
+};
+
+// Weighted cosine similarity, computed exactly in double precision. On weighted
+// graphs, the similarity between adjacent vertices u and v is
+//   (sum(weight({u, z}) * weight({v, z}) for z in the intersection of the
+//      closed neighborhoods of u and v) / (norm(u) * norm(v)))
+// with `norm` and the self-loop weight `weight({v, v}) = 1` as in
+// `CosineSimilarity`. Unlike `CosineSimilarity`, the edge weights are not
+// rounded to integers, so small or large weights keep their precision. On
+// unweighted graphs this is the same as `CosineSimilarity`.
+class WeightedCosineSimilarity {
+ public:
+  WeightedCosineSimilarity() = default;
+
+  template <class Graph>
+  sequence<EdgeSimilarity> AllEdges(Graph* graph) const;
+};
+
+// Weighted Jaccard (Ruzicka) similarity. On weighted graphs, the similarity
+// between adjacent vertices u and v is
+//   sum(min(weight({u, z}), weight({v, z}))) /
+//   sum(max(weight({u, z}), weight({v, z})))
+// with both sums over the union of the closed neighborhoods of u and v,
+// where a missing edge has weight 0 and `weight({v, v}) = 1`. Edge weights
+// should be non-negative. On unweighted graphs this is the same as
+// `JaccardSimilarity`.
+class WeightedJaccardSimilarity {
+ public:
+  WeightedJaccardSimilarity() = default;
+
+  template <class Graph>
+  sequence<EdgeSimilarity> AllEdges(Graph* graph) const;
 };
 
 // This is an approximate version of `CosineSimilarity`. Increasing
@@ -107,9 +140,8 @@ struct ApproxCosineSimilarity {
   ApproxCosineSimilarity(uint32_t num_samples, size_t random_seed);
 
   // When `random_seed` is fixed, the output of `AllEdges` is deterministic.
-  template <template <typename> class VertexTemplate, typename Weight>
-  sequence<EdgeSimilarity> AllEdges(
-      symmetric_graph<VertexTemplate, Weight>* graph) const;
+  template <class Graph>
+  sequence<EdgeSimilarity> AllEdges(Graph* graph) const;
 
  private:
   const uint32_t num_samples_;
@@ -117,7 +149,8 @@ struct ApproxCosineSimilarity {
 };
 
 // This is an approximate version of `JaccardSimilarity`. Increasing
-// `num_samples` increases the approximation accuracy.
+// `num_samples` increases the approximation accuracy. Like
+// `JaccardSimilarity`, it ignores edge weights.
 //
 // This is really only helpful for graphs with lots of high degree vertices.
 // Otherwise, the cost to approximate similarities with enough samples to have
@@ -127,9 +160,8 @@ struct ApproxJaccardSimilarity {
   ApproxJaccardSimilarity(uint32_t num_samples, size_t random_seed);
 
   // When `random_seed` is fixed, the output of `AllEdges` is deterministic.
-  template <template <typename> class VertexTemplate>
-  sequence<EdgeSimilarity> AllEdges(
-      symmetric_graph<VertexTemplate, gbbs::empty>* graph) const;
+  template <class Graph>
+  sequence<EdgeSimilarity> AllEdges(Graph* graph) const;
 
  private:
   const uint32_t num_samples_;
@@ -211,6 +243,7 @@ template <class Graph, class F>
 sequence<EdgeSimilarity> AllEdgeNeighborhoodSimilarities(
     Graph* graph,
     F&& neighborhood_sizes_to_similarity) {
+  using Weight = typename Graph::weight_type;
   // Counting the neighbors shared between adjacent vertices u and v is the same
   // as counting the number of triangles that the edge {u, v} appears in.
   //
@@ -238,7 +271,7 @@ sequence<EdgeSimilarity> AllEdgeNeighborhoodSimilarities(
     auto vertex{directed_graph.get_vertex(vertex_id)};
     const uintT vertex_counter_offset{counter_offsets[vertex_id]};
     const auto intersect{[&](const uintE v_id, const uintE neighbor_id,
-                             gbbs::empty, const uintE v_to_neighbor_index) {
+                             Weight, const uintE v_to_neighbor_index) {
       auto neighbor{directed_graph.get_vertex(neighbor_id)};
       const uintT neighbor_counter_offset{counter_offsets[neighbor_id]};
       const auto update_counters{[&](const uintE shared_neighbor,
@@ -248,8 +281,8 @@ sequence<EdgeSimilarity> AllEdgeNeighborhoodSimilarities(
         counters[neighbor_counter_offset + neighbor_to_shared_index]++;
       }};
       counters[vertex_counter_offset + v_to_neighbor_index] +=
-          internal::intersect_f_with_index_par(&vertex, &neighbor,
-                                               update_counters);
+          internal::intersect_structure_f_with_index_par(&vertex, &neighbor,
+                                                         update_counters);
     }};
     constexpr bool kParallel{false};
     vertex.out_neighbors().map_with_index(intersect, kParallel);
@@ -261,7 +294,7 @@ sequence<EdgeSimilarity> AllEdgeNeighborhoodSimilarities(
     const uintT v_counter_offset{counter_offsets[vertex_id]};
     const uintE v_degree{graph->get_vertex(vertex_id).out_degree()};
     const auto compute_similarity{[&](const uintE v_id, const uintE u_id,
-                                      gbbs::empty, const uintE v_to_u_index) {
+                                      Weight, const uintE v_to_u_index) {
       const uintT counter_index{v_counter_offset + v_to_u_index};
       const uintE num_shared_neighbors{counters[counter_index]};
       const uintE u_degree{graph->get_vertex(u_id).out_degree()};
@@ -279,15 +312,108 @@ sequence<EdgeSimilarity> AllEdgeNeighborhoodSimilarities(
   return similarities;
 }
 
+// Weighted counterpart of `AllEdgeNeighborhoodSimilarities`. Returns a
+// `graph->m`-length sequence containing the similarity score between every
+// adjacent pair of vertices u and v of a weighted graph.
+//
+// Arguments:
+//   graph
+//     Weighted graph on which to compute similarities.
+//   combine_shared_weights: (double, double) -> double
+//     For each neighbor z shared by u and v, the similarity accumulates
+//     `combine_shared_weights(weight({u, z}), weight({v, z}))`.
+//   to_similarity: (uintE, uintE, double, double) -> float
+//     Computes the similarity between adjacent vertices u and v, taking (u, v,
+//     weight({u, v}), accumulated shared-neighbor sum) as arguments. It should
+//     be symmetric in u and v.
+template <class Graph, class F, class G>
+sequence<EdgeSimilarity> AllEdgeWeightedNeighborhoodSimilarities(
+    Graph* graph, F&& combine_shared_weights, G&& to_similarity) {
+  using Weight = typename Graph::weight_type;
+  // As in `AllEdgeNeighborhoodSimilarities`, shared neighbors are found by
+  // enumerating each triangle once in a degree-ordered directed graph. Sums
+  // are accumulated in double precision with compare-and-swap additions.
+  auto directed_graph{DirectGraphByDegree(graph)};
+  auto shared_sums = sequence<double>(directed_graph.m, 0.0);
+  const sequence<uintT> counter_offsets{
+      internal::VertexOutOffsets(&directed_graph)};
+  parallel_for(0, graph->n, [&](const size_t vertex_id) {
+    auto vertex{directed_graph.get_vertex(vertex_id)};
+    const uintT vertex_counter_offset{counter_offsets[vertex_id]};
+    const auto intersect{[&](const uintE v_id, const uintE neighbor_id,
+                             const Weight weight,
+                             const uintE v_to_neighbor_index) {
+      auto neighbor{directed_graph.get_vertex(neighbor_id)};
+      const uintT neighbor_counter_offset{counter_offsets[neighbor_id]};
+      double edge_sum{0.0};
+      const auto update_sums{[&](const uintE shared_neighbor,
+                                 const uintE vertex_to_shared_index,
+                                 const uintE neighbor_to_shared_index,
+                                 const Weight weight_1, const Weight weight_2) {
+        // Triangle {vertex, neighbor, shared_neighbor} contributes to each of
+        // its three edges via the vertex opposite that edge.
+        edge_sum += combine_shared_weights(weight_1, weight_2);
+        gbbs::write_add(
+            &shared_sums[vertex_counter_offset + vertex_to_shared_index],
+            combine_shared_weights(weight, weight_2));
+        gbbs::write_add(
+            &shared_sums[neighbor_counter_offset + neighbor_to_shared_index],
+            combine_shared_weights(weight, weight_1));
+      }};
+      internal::intersect_f_with_index_par(&vertex, &neighbor, update_sums);
+      gbbs::write_add(&shared_sums[vertex_counter_offset + v_to_neighbor_index],
+                      edge_sum);
+    }};
+    constexpr bool kParallel{false};
+    vertex.out_neighbors().map_with_index(intersect, kParallel);
+  });
+
+  sequence<EdgeSimilarity> similarities(graph->m);
+  parallel_for(0, directed_graph.n, [&](const size_t vertex_id) {
+    const uintT v_counter_offset{counter_offsets[vertex_id]};
+    const auto compute_similarity{[&](const uintE v_id, const uintE u_id,
+                                      const Weight weight,
+                                      const uintE v_to_u_index) {
+      const uintT counter_index{v_counter_offset + v_to_u_index};
+      const float similarity{
+          to_similarity(v_id, u_id, weight, shared_sums[counter_index])};
+      similarities[2 * counter_index] = {
+          .source = v_id, .neighbor = u_id, .similarity = similarity};
+      similarities[2 * counter_index + 1] = {
+          .source = u_id, .neighbor = v_id, .similarity = similarity};
+    }};
+    directed_graph.get_vertex(vertex_id).out_neighbors().map_with_index(
+        compute_similarity);
+  });
+
+  return similarities;
+}
+
+// Returns a `graph->n`-length sequence whose i-th entry is
+// `sum(f(weight({i, z})) for z in the closed neighborhood of i)`, using a
+// self-loop weight of 1.
+template <class Graph, class F>
+sequence<double> ClosedNeighborhoodWeightSums(Graph* graph, F&& f) {
+  using Weight = typename Graph::weight_type;
+  return sequence<double>::from_function(graph->n, [&](const size_t vertex_id) {
+    double sum{f(1.0)};
+    constexpr bool kParallel{false};
+    graph->get_vertex(vertex_id).out_neighbors().map(
+        [&](uintE, uintE, const Weight weight) { sum += f(weight); },
+        kParallel);
+    return sum;
+  });
+}
+
 // Implementation of ApproxCosineSimilarities::AllEdges.
 //
 // `degree_threshold` is a threshold so that we only approximate the similarity
 // score between two vertices if their degrees are high enough. (When the
 // degrees are low, it's cheap to compute the similarity exactly.)
-template <template <typename> class VertexTemplate, typename Weight>
+template <class Graph>
 sequence<EdgeSimilarity> ApproxCosineEdgeSimilarities(
-    symmetric_graph<VertexTemplate, Weight>* graph, const uint32_t num_samples,
-    const size_t degree_threshold, const size_t random_seed) {
+    Graph* graph, const uint32_t num_samples, const size_t degree_threshold,
+    const size_t random_seed) {
   // Approximates cosine similarity using SimHash (c.f. "Similarity Estimation
   // Techniques from Rounding Algorithms" by Moses Charikar).
   //
@@ -305,7 +431,7 @@ sequence<EdgeSimilarity> ApproxCosineEdgeSimilarities(
   // For edges between high degree vertices, estimate the similarity with
   // SimHash. For edges with a low degree vertex, compute the similarity exactly
   // with triangle counting like in `AllEdgeNeighborhoodSimilarities()`.
-  using Vertex = VertexTemplate<Weight>;
+  using Weight = typename Graph::weight_type;
   // We compute `num_samples_` hyperplanes and, to sketch a vertex's
   // neighborhood vector, we compute `num_samples_` bits representing the sign
   // of the vector's dot product with each hyperplane. For efficiency, we store
@@ -318,7 +444,7 @@ sequence<EdgeSimilarity> ApproxCosineEdgeSimilarities(
   sequence<uintE> needs_fingerprint_seq(graph->n, 0U);
   sequence<uintE> needs_normals_seq(graph->n, 0U);
   parallel_for(0, graph->n, [&](const size_t vertex_id) {
-    Vertex vertex{graph->get_vertex(vertex_id)};
+    auto vertex{graph->get_vertex(vertex_id)};
     if (vertex.out_degree() >= degree_threshold) {
       // Vertex should be fingerprinted if both it and one of its neighbors
       // has high degree. If a vertex needs to be fingerprinted, then normal
@@ -327,7 +453,7 @@ sequence<EdgeSimilarity> ApproxCosineEdgeSimilarities(
       const auto check_degree_threshold{
           [&](uintE, const uintE neighbor_id, Weight) {
             if (skip_fingerprint &&
-                graph->v_data[neighbor_id].degree >= degree_threshold) {
+                graph->get_vertex(neighbor_id).out_degree() >= degree_threshold) {
               skip_fingerprint = false;
             }
           }};
@@ -368,7 +494,7 @@ sequence<EdgeSimilarity> ApproxCosineEdgeSimilarities(
     if (!needs_fingerprint) {
       return;
     }
-    Vertex vertex{graph->get_vertex(vertex_id)};
+    auto vertex{graph->get_vertex(vertex_id)};
     const uintE vertex_normal_offset{num_samples * normals_indices[vertex_id]};
     const size_t fingerprint_offset{fingerprint_index * num_bit_arrays};
     parallel_for(0, num_bit_arrays, [&](const size_t bit_array_id) {
@@ -444,7 +570,7 @@ sequence<EdgeSimilarity> ApproxCosineEdgeSimilarities(
   // original, undirected graph.
   parallel_for(0, graph->n, [&](const size_t vertex_id) {
     auto vertex{directed_graph.get_vertex(vertex_id)};
-    const bool vertex_is_high_degree{graph->v_data[vertex_id].degree >=
+    const bool vertex_is_high_degree{graph->get_vertex(vertex_id).out_degree() >=
                                      degree_threshold};
     if (vertex_is_high_degree) {
       // Since all edges in the directed graph point towards higher degree
@@ -459,7 +585,7 @@ sequence<EdgeSimilarity> ApproxCosineEdgeSimilarities(
                              [[maybe_unused]] const Weight weight,
                              const uintE v_to_neighbor_index) {
       auto neighbor{directed_graph.get_vertex(neighbor_id)};
-      const bool neighbor_is_high_degree{graph->v_data[neighbor_id].degree >=
+      const bool neighbor_is_high_degree{graph->get_vertex(neighbor_id).out_degree() >=
                                          degree_threshold};
       const uintT neighbor_counter_offset{counter_offsets[neighbor_id]};
 
@@ -471,7 +597,7 @@ sequence<EdgeSimilarity> ApproxCosineEdgeSimilarities(
                                          const uintE neighbor_to_shared_index) {
             counters[vertex_counter_offset + vertex_to_shared_index]++;
             if (!(neighbor_is_high_degree &&
-                  graph->v_data[shared_neighbor].degree >= degree_threshold)) {
+                  graph->get_vertex(shared_neighbor).out_degree() >= degree_threshold)) {
               counters[neighbor_counter_offset + neighbor_to_shared_index]++;
             }
           }};
@@ -488,7 +614,7 @@ sequence<EdgeSimilarity> ApproxCosineEdgeSimilarities(
           counters[vertex_counter_offset + vertex_to_shared_index] +=
               kWeightFactor * kWeightFactor * weight * weight_2;
           if (!(neighbor_is_high_degree &&
-                graph->v_data[shared_neighbor].degree >= degree_threshold)) {
+                graph->get_vertex(shared_neighbor).out_degree() >= degree_threshold)) {
             counters[neighbor_counter_offset + neighbor_to_shared_index] +=
                 kWeightFactor * kWeightFactor * weight * weight_1;
           }
@@ -586,13 +712,11 @@ sequence<EdgeSimilarity> ApproxCosineEdgeSimilarities(
 // `degree_threshold` is a threshold so that we only approximate the similarity
 // score between two vertices if their degrees are high enough. (When the
 // degrees are low, it's cheap to compute the similarity exactly.)
-template <template <typename> class VertexTemplate>
+template <class Graph>
 sequence<EdgeSimilarity> ApproxJaccardEdgeSimilarities(
-    symmetric_graph<VertexTemplate, gbbs::empty>* graph,
-    const uint32_t original_num_samples, const size_t degree_threshold,
-    const size_t random_seed) {
-  using Weight = gbbs::empty;
-  using Vertex = VertexTemplate<Weight>;
+    Graph* graph, const uint32_t original_num_samples,
+    const size_t degree_threshold, const size_t random_seed) {
+  using Weight = typename Graph::weight_type;
   // For edges between high degree vertices, estimate the Jaccard similarity
   // with a MinHash variant --- see paper "One Permutation Hashing for Efficient
   // Search and Learning."
@@ -620,7 +744,7 @@ sequence<EdgeSimilarity> ApproxJaccardEdgeSimilarities(
 
   auto needs_fingerprint_seq =
       sequence<uintE>::from_function(graph->n, [&](const size_t vertex_id) {
-        Vertex vertex{graph->get_vertex(vertex_id)};
+        auto vertex{graph->get_vertex(vertex_id)};
         if (vertex.out_degree() < degree_threshold) {
           return false;
         }
@@ -628,7 +752,7 @@ sequence<EdgeSimilarity> ApproxJaccardEdgeSimilarities(
         const auto check_degree_threshold{
             [&](uintE, const uintE neighbor_id, Weight) {
               if (!needs_fingerprint &&
-                  graph->v_data[neighbor_id].degree >= degree_threshold) {
+                  graph->get_vertex(neighbor_id).out_degree() >= degree_threshold) {
                 needs_fingerprint = true;
               }
             }};
@@ -651,17 +775,17 @@ sequence<EdgeSimilarity> ApproxJaccardEdgeSimilarities(
       return;
     }
 
-    Vertex vertex{graph->get_vertex(vertex_id)};
+    auto vertex{graph->get_vertex(vertex_id)};
     const size_t fingerprint_offset{fingerprint_index * num_samples};
     const auto update_fingerprint{
-        [&](uintE, const uintE neighbor, gbbs::empty) {
+        [&](uintE, const uintE neighbor, Weight) {
           const uintE permuted_neighbor{vertex_permutation[neighbor]};
           const uintE bucket_id{permuted_neighbor & bucket_mask};
           const uintE bucket_value{permuted_neighbor >> log_num_samples};
           gbbs::write_min(&(fingerprints[fingerprint_offset + bucket_id]),
                           bucket_value, std::less<uintE>{});
         }};
-    update_fingerprint(vertex_id, vertex_id, gbbs::empty{});
+    update_fingerprint(vertex_id, vertex_id, Weight{});
     vertex.out_neighbors().map(update_fingerprint);
   });
 
@@ -683,7 +807,7 @@ sequence<EdgeSimilarity> ApproxJaccardEdgeSimilarities(
   // original, undirected graph.
   parallel_for(0, graph->n, [&](const size_t vertex_id) {
     auto vertex{directed_graph.get_vertex(vertex_id)};
-    const bool vertex_is_high_degree{graph->v_data[vertex_id].degree >=
+    const bool vertex_is_high_degree{graph->get_vertex(vertex_id).out_degree() >=
                                      degree_threshold};
     if (vertex_is_high_degree) {
       // Since all edges in the directed graph point towards higher degree
@@ -695,9 +819,9 @@ sequence<EdgeSimilarity> ApproxJaccardEdgeSimilarities(
 
     const uintT vertex_counter_offset{counter_offsets[vertex_id]};
     const auto intersect{[&](const uintE v_id, const uintE neighbor_id,
-                             gbbs::empty, const uintE v_to_neighbor_index) {
+                             Weight, const uintE v_to_neighbor_index) {
       auto neighbor{directed_graph.get_vertex(neighbor_id)};
-      const bool neighbor_is_high_degree{graph->v_data[neighbor_id].degree >=
+      const bool neighbor_is_high_degree{graph->get_vertex(neighbor_id).out_degree() >=
                                          degree_threshold};
       const uintT neighbor_counter_offset{counter_offsets[neighbor_id]};
       const auto update_counters{[&](const uintE shared_neighbor,
@@ -705,13 +829,13 @@ sequence<EdgeSimilarity> ApproxJaccardEdgeSimilarities(
                                      const uintE neighbor_to_shared_index) {
         counters[vertex_counter_offset + vertex_to_shared_index]++;
         if (!(neighbor_is_high_degree &&
-              graph->v_data[shared_neighbor].degree >= degree_threshold)) {
+              graph->get_vertex(shared_neighbor).out_degree() >= degree_threshold)) {
           counters[neighbor_counter_offset + neighbor_to_shared_index]++;
         }
       }};
       counters[vertex_counter_offset + v_to_neighbor_index] +=
-          internal::intersect_f_with_index_par(&vertex, &neighbor,
-                                               update_counters);
+          internal::intersect_structure_f_with_index_par(&vertex, &neighbor,
+                                                         update_counters);
     }};
     constexpr bool kParallel{false};
     vertex.out_neighbors().map_with_index(intersect, kParallel);
@@ -726,7 +850,7 @@ sequence<EdgeSimilarity> ApproxJaccardEdgeSimilarities(
     const size_t vertex_fingerprint_offset{fingerprint_indices[vertex_id] *
                                            num_samples};
     const auto compute_similarity{[&](const uintE v_id, const uintE u_id,
-                                      gbbs::empty, const uintE v_to_u_index) {
+                                      Weight, const uintE v_to_u_index) {
       const uintT counter_index{v_counter_offset + v_to_u_index};
       float similarity{-1};
       if (vertex_is_high_degree) {  // approximate similarity
@@ -876,9 +1000,8 @@ sequence<EdgeSimilarity> CosineSimilarity::AllEdges(
   }
 }
 
-template <template <typename> class VertexTemplate>
-sequence<EdgeSimilarity> JaccardSimilarity::AllEdges(
-    symmetric_graph<VertexTemplate, gbbs::empty>* graph) const {
+template <class Graph>
+sequence<EdgeSimilarity> JaccardSimilarity::AllEdges(Graph* graph) const {
   constexpr auto similarity_func{[](const uintE neighborhood_size_1,
                                     const uintE neighborhood_size_2,
                                     const uintE num_shared_neighbors) {
@@ -891,17 +1014,72 @@ sequence<EdgeSimilarity> JaccardSimilarity::AllEdges(
   return internal::AllEdgeNeighborhoodSimilarities(graph, similarity_func);
 }
 
-template <template <typename> class VertexTemplate, typename Weight>
-sequence<EdgeSimilarity> ApproxCosineSimilarity::AllEdges(
-    symmetric_graph<VertexTemplate, Weight>* graph) const {
+template <class Graph>
+sequence<EdgeSimilarity> WeightedCosineSimilarity::AllEdges(
+    Graph* graph) const {
+  using Weight = typename Graph::weight_type;
+  if
+    constexpr(std::is_same<Weight, gbbs::empty>::value) {  // unweighted
+      return CosineSimilarity{}.AllEdges(graph);
+    }
+  else {  // weighted case
+    const sequence<double> norms{parlay::map(
+        internal::ClosedNeighborhoodWeightSums(
+            graph, [](const double weight) { return weight * weight; }),
+        [](const double squared_norm) { return std::sqrt(squared_norm); })};
+    return internal::AllEdgeWeightedNeighborhoodSimilarities(
+        graph,
+        [](const double weight_1, const double weight_2) {
+          return weight_1 * weight_2;
+        },
+        [&](const uintE u, const uintE v, const double weight,
+            const double shared_sum) {
+          // The `2 * weight` term is the contribution of u and v themselves,
+          // each of which has self-loop weight 1.
+          return static_cast<float>((shared_sum + 2 * weight) /
+                                    (norms[u] * norms[v]));
+        });
+  }
+}
+
+template <class Graph>
+sequence<EdgeSimilarity> WeightedJaccardSimilarity::AllEdges(
+    Graph* graph) const {
+  using Weight = typename Graph::weight_type;
+  if
+    constexpr(std::is_same<Weight, gbbs::empty>::value) {  // unweighted
+      return JaccardSimilarity{}.AllEdges(graph);
+    }
+  else {  // weighted case
+    const sequence<double> totals{internal::ClosedNeighborhoodWeightSums(
+        graph, [](const double weight) { return weight; })};
+    return internal::AllEdgeWeightedNeighborhoodSimilarities(
+        graph,
+        [](const double weight_1, const double weight_2) {
+          return std::min(weight_1, weight_2);
+        },
+        [&](const uintE u, const uintE v, const double weight,
+            const double shared_sum) {
+          // u and v are shared neighbors of each other's closed neighborhood,
+          // each contributing min(1, weight). Since max(a, b) = a + b -
+          // min(a, b), the sum of maxima over the union is the sum of both
+          // closed neighborhoods' weights minus the sum of minima.
+          const double min_sum{shared_sum + 2 * std::min(1.0, weight)};
+          const double max_sum{totals[u] + totals[v] - min_sum};
+          return max_sum > 0 ? static_cast<float>(min_sum / max_sum) : 0.0f;
+        });
+  }
+}
+
+template <class Graph>
+sequence<EdgeSimilarity> ApproxCosineSimilarity::AllEdges(Graph* graph) const {
   const size_t degree_threshold{static_cast<size_t>(1.5 * num_samples_)};
   return internal::ApproxCosineEdgeSimilarities(graph, num_samples_,
                                                 degree_threshold, random_seed_);
 }
 
-template <template <typename> class VertexTemplate>
-sequence<EdgeSimilarity> ApproxJaccardSimilarity::AllEdges(
-    symmetric_graph<VertexTemplate, gbbs::empty>* graph) const {
+template <class Graph>
+sequence<EdgeSimilarity> ApproxJaccardSimilarity::AllEdges(Graph* graph) const {
   const size_t degree_threshold{static_cast<size_t>(1.0 * num_samples_)};
   return internal::ApproxJaccardEdgeSimilarities(
       graph, num_samples_, degree_threshold, random_seed_);
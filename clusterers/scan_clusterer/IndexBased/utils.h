@@ -5,8 +5,11 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 #include "gbbs/bridge.h"
@@ -71,6 +74,12 @@ template <template <typename> class VertexTemplate, typename Weight>
 double Modularity(symmetric_graph<VertexTemplate, Weight>* graph,
                   const Clustering& clustering);
 
+// Returns a 64-bit hash of the vertices, edges and edge weights of `graph` that
+// does not depend on the order of neighbor lists. Used to tag a persisted
+// `indexed_scan::Index` with the graph it was built from.
+template <class Graph>
+uint64_t GraphFingerprint(Graph* graph);
+
 //////////////
 // Internal //
 //////////////
@@ -127,8 +136,41 @@ decltype(auto) CollectReduce(
   return result;
 }
 
+// Returns the bit pattern of an edge weight, or 0 for unweighted edges.
+template <class Weight>
+uint64_t WeightBits(const Weight& weight) {
+  if constexpr (std::is_same<Weight, gbbs::empty>::value) {
+    return 0;
+  } else {
+    static_assert(sizeof(Weight) <= sizeof(uint64_t));
+    uint64_t bits{0};
+    std::memcpy(&bits, &weight, sizeof(Weight));
+    return bits;
+  }
+}
+
 }  // namespace internal
 
+template <class Graph>
+uint64_t GraphFingerprint(Graph* graph) {
+  using Weight = typename Graph::weight_type;
+  // Summing per-edge hashes makes the fingerprint independent of the order in
+  // which edges are visited.
+  const auto vertex_hashes{
+      parlay::delayed_seq<uint64_t>(graph->n, [&](const size_t v) {
+        uint64_t hash{0};
+        graph->get_vertex(v).out_neighbors().map(
+            [&](const uintE u, const uintE w, const Weight weight) {
+              hash += parlay::hash64((static_cast<uint64_t>(u) << 32) | w) ^
+                      parlay::hash64_2(internal::WeightBits(weight) + 1);
+            },
+            false);
+        return hash;
+      })};
+  return parlay::hash64(graph->n) ^ parlay::hash64_2(graph->m) ^
+         parlay::reduce(vertex_hashes);
+}
+
 template <class Vertex>
 UnclusteredType DetermineUnclusteredType(const Clustering& clustering,
                                          Vertex vertex, uintE vertex_id) {
@@ -137,7 +179,7 @@ UnclusteredType DetermineUnclusteredType(const Clustering& clustering,
   // `kUnclustered` before such a cluster is found.
   uintE candidate_cluster{kUnclustered};
   const auto check_neighbor{
-      [&](const uintE v_id, const uintE neighbor_id, gbbs::empty) {
+      [&](const uintE v_id, const uintE neighbor_id, const auto&) {
         const uintE neighbor_cluster{clustering[neighbor_id]};
         // If `candidate_cluster` is at its default value of `kUnclustered`,
         // assign
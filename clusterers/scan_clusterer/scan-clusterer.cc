@@ -1,11 +1,18 @@
 #include "clusterers/scan_clusterer/scan-clusterer.h"
 
 #include <algorithm>
+#include <fstream>
+#include <functional>
 #include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "clusterers/scan_clusterer/scan_config.pb.h"
 #include "clusterers/scan_clusterer/IndexBased/scan.h"
 #include "clusterers/scan_clusterer/IndexBased/utils.h"
@@ -19,23 +26,275 @@
 namespace research_graph {
 namespace in_memory {
 
-absl::StatusOr<ScanClusterer::Clustering>
-ScanClusterer::Cluster(const ClustererConfig& config) const {
+namespace {
+
+// The (mu, epsilon) pairs of a ScanClustererConfig: every mu is combined with
+// every epsilon.
+struct ScanParameters {
+  std::vector<int64_t> mus;
+  parlay::sequence<float> epsilons;
+
+  std::size_t size() const { return mus.size() * epsilons.size(); }
+};
+
+ScanParameters GetScanParameters(const ScanClustererConfig& scan_config) {
+  ScanParameters parameters;
+  if (scan_config.mus_size() > 0) {
+    parameters.mus.assign(scan_config.mus().begin(), scan_config.mus().end());
+  } else {
+    parameters.mus.push_back(scan_config.mu());
+  }
+  if (scan_config.epsilons_size() > 0) {
+    parameters.epsilons = parlay::sequence<float>::from_function(
+        scan_config.epsilons_size(),
+        [&](std::size_t i) { return scan_config.epsilons(i); });
+  } else {
+    parameters.epsilons = parlay::sequence<float>(1, scan_config.epsilon());
+  }
+  return parameters;
+}
+
+gbbs::indexed_scan::CoreOrderOptions GetCoreOrderOptions(
+    const ScanClustererConfig& scan_config, const ScanParameters& parameters) {
+  gbbs::indexed_scan::CoreOrderOptions options;
+  if (!scan_config.precompute_all_mu()) {
+    const auto [min_mu, max_mu] =
+        std::minmax_element(parameters.mus.begin(), parameters.mus.end());
+    options.min_mu = *min_mu;
+    options.max_mu = *max_mu;
+  }
+  options.max_bytes = scan_config.core_order_max_bytes();
+  return options;
+}
+
+template <class Graph>
+std::unique_ptr<gbbs::indexed_scan::Index> BuildIndex(
+    Graph* graph, const ScanClustererConfig& scan_config,
+    const ScanParameters& parameters) {
+  using gbbs::indexed_scan::Index;
+  const auto options = GetCoreOrderOptions(scan_config, parameters);
+  switch (scan_config.similarity_measure()) {
+    case ScanClustererConfig::JACCARD:
+      return std::make_unique<Index>(graph, gbbs::scan::JaccardSimilarity{},
+                                     options);
+    case ScanClustererConfig::WEIGHTED_COSINE:
+      return std::make_unique<Index>(
+          graph, gbbs::scan::WeightedCosineSimilarity{}, options);
+    case ScanClustererConfig::WEIGHTED_JACCARD:
+      return std::make_unique<Index>(
+          graph, gbbs::scan::WeightedJaccardSimilarity{}, options);
+    case ScanClustererConfig::APPROX_COSINE:
+      return std::make_unique<Index>(
+          graph,
+          gbbs::scan::ApproxCosineSimilarity{scan_config.num_samples(),
+                                             scan_config.random_seed()},
+          options);
+    case ScanClustererConfig::APPROX_JACCARD:
+      return std::make_unique<Index>(
+          graph,
+          gbbs::scan::ApproxJaccardSimilarity{scan_config.num_samples(),
+                                              scan_config.random_seed()},
+          options);
+    case ScanClustererConfig::COSINE:
+    default:
+      return std::make_unique<Index>(graph, gbbs::scan::CosineSimilarity{},
+                                     options);
+  }
+}
+
+// Returns a fingerprint of `graph` and of the settings in `scan_config` that
+// affect the index built from it.
+template <class Graph>
+uint64_t IndexFingerprint(Graph* graph,
+                          const ScanClustererConfig& scan_config) {
+  uint64_t fingerprint = gbbs::scan::GraphFingerprint(graph);
+  const auto mix = [&](uint64_t value) {
+    fingerprint = parlay::hash64(fingerprint ^ parlay::hash64_2(value));
+  };
+  mix(scan_config.similarity_measure());
+  switch (scan_config.similarity_measure()) {
+    case ScanClustererConfig::APPROX_COSINE:
+    case ScanClustererConfig::APPROX_JACCARD:
+      mix(scan_config.num_samples());
+      mix(scan_config.random_seed());
+      break;
+    default:
+      break;
+  }
+  return fingerprint;
+}
+
+// Returns the index for `scan_config`, loaded from `index_file` if set and
+// present, or built otherwise (and then saved to `index_file` if set).
+template <class Graph>
+absl::StatusOr<std::unique_ptr<gbbs::indexed_scan::Index>> GetIndex(
+    Graph* graph, const ScanClustererConfig& scan_config,
+    const ScanParameters& parameters) {
+  const std::string& index_file = scan_config.index_file();
+  if (index_file.empty()) return BuildIndex(graph, scan_config, parameters);
+
+  const uint64_t fingerprint = IndexFingerprint(graph, scan_config);
+  if (std::ifstream(index_file).good()) {
+    auto index = gbbs::indexed_scan::Index::Load(
+        index_file, fingerprint, scan_config.core_order_max_bytes());
+    if (index == nullptr) {
+      return absl::FailedPreconditionError(absl::StrCat(
+          "index_file ", index_file,
+          " is not a SCAN index of this graph and similarity measure"));
+    }
+    std::cout << "Loaded SCAN index from " << index_file << std::endl;
+    return index;
+  }
+  auto index = BuildIndex(graph, scan_config, parameters);
+  if (!index->Save(index_file, fingerprint)) {
+    return absl::NotFoundError(
+        absl::StrCat("Unable to write index_file ", index_file));
+  }
+  std::cout << "Saved SCAN index to " << index_file << std::endl;
+  return index;
+}
+
+// Returns the file of the (mu, epsilon) clustering of a sweep written to
+// `prefix`.
+std::string SweepFilename(const std::string& prefix, int64_t mu,
+                          float epsilon) {
+  return absl::StrCat(prefix, "-mu", mu, "-eps", epsilon);
+}
+
+absl::Status WriteClustering(const std::string& filename,
+                             const InMemoryClusterer::Clustering& clustering) {
+  std::ofstream file{filename};
+  if (!file.is_open()) {
+    return absl::NotFoundError("Unable to open file.");
+  }
+  for (const auto& cluster : clustering) {
+    for (auto node_id : cluster) {
+      file << node_id << "\t";
+    }
+    file << std::endl;
+  }
+  return absl::OkStatus();
+}
+
+// Writes the vertices that `clustering` leaves unclustered to `filename`, each
+// as a "<vertex>\t<hub|outlier>" line.
+template <class Graph>
+absl::Status WriteUnclusteredTypes(
+    const std::string& filename, Graph* graph,
+    const gbbs::indexed_scan::Clustering& clustering) {
+  const auto unclustered = parlay::pack_index<gbbs::uintE>(
+      parlay::delayed_seq<bool>(clustering.size(), [&](std::size_t i) {
+        return clustering[i] == gbbs::scan::kUnclustered;
+      }));
+  const auto types = parlay::map(unclustered, [&](gbbs::uintE vertex_id) {
+    return gbbs::scan::DetermineUnclusteredType(
+        clustering, graph->get_vertex(vertex_id), vertex_id);
+  });
+  std::ofstream file{filename};
+  if (!file.is_open()) {
+    return absl::NotFoundError("Unable to open file.");
+  }
+  for (std::size_t i = 0; i < unclustered.size(); i++) {
+    file << unclustered[i] << '\t' << types[i] << '\n';
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::Status ScanClusterer::ClusterAll(
+    const ClustererConfig& config,
+    const std::function<absl::Status(int64_t, float, Clustering&&)>& f) const {
   ScanClustererConfig scan_config;
   config.any_config().UnpackTo(&scan_config);
-  std::size_t mu = scan_config.mu();
-  double epsilon = scan_config.epsilon();
+  const ScanParameters parameters = GetScanParameters(scan_config);
+  bool get_deterministic_result = scan_config.get_deterministic_result();
 
-  std::cout << "Scan parameters: mu = " << mu << ", epsilon = " << epsilon
+  std::cout << "Scan parameters: mu = {";
+  for (std::size_t i = 0; i < parameters.mus.size(); i++) {
+    std::cout << (i == 0 ? "" : ", ") << parameters.mus[i];
+  }
+  std::cout << "}, epsilon = {";
+  for (std::size_t i = 0; i < parameters.epsilons.size(); i++) {
+    std::cout << (i == 0 ? "" : ", ") << parameters.epsilons[i];
+  }
+  std::cout << "}, similarity_measure = "
+            << ScanClustererConfig::SimilarityMeasure_Name(
+                   scan_config.similarity_measure())
+            << ", get_deterministic_result = " << get_deterministic_result
             << '\n';
 
-  const gbbs::indexed_scan::Index scan_index{graph_.Graph(), gbbs::scan::CosineSimilarity{}};
+  if (std::any_of(parameters.mus.begin(), parameters.mus.end(),
+                  [](int64_t mu) { return mu < 1; })) {
+    return absl::InvalidArgumentError("mu must be positive");
+  }
+
+  ASSIGN_OR_RETURN(const auto scan_index,
+                   GetIndex(graph_.Graph(), scan_config, parameters));
+
+  const std::string& unclustered_output_file =
+      scan_config.unclustered_output_file();
+  // The first error stops any further writes; the remaining clusterings of
+  // the current mu are still computed but dropped.
+  absl::Status status;
+  for (std::size_t i = 0; i < parameters.mus.size() && status.ok(); i++) {
+    scan_index->Cluster(
+        parameters.mus[i], parameters.epsilons,
+        [&](gbbs::indexed_scan::Clustering&& clustering, std::size_t j) {
+          if (!status.ok()) return;
+          if (!unclustered_output_file.empty()) {
+            // Hubs and outliers are only defined against this clustering, so
+            // they are found while it is still in dense form.
+            status = WriteUnclusteredTypes(
+                parameters.size() == 1
+                    ? unclustered_output_file
+                    : SweepFilename(unclustered_output_file,
+                                    parameters.mus[i], parameters.epsilons[j]),
+                graph_.Graph(), clustering);
+            if (!status.ok()) return;
+          }
+          status = f(parameters.mus[i], parameters.epsilons[j],
+                     research_graph::DenseClusteringToNestedClustering<
+                         gbbs::uintE>(clustering));
+        },
+        get_deterministic_result);
+  }
+  return status;
+}
+
+absl::StatusOr<ScanClusterer::Clustering>
+ScanClusterer::Cluster(const ClustererConfig& config) const {
+  ScanClustererConfig scan_config;
+  config.any_config().UnpackTo(&scan_config);
+  const ScanParameters parameters = GetScanParameters(scan_config);
+  const std::string& output_prefix = scan_config.sweep_output_prefix();
+  if (output_prefix.empty() && parameters.size() > 1) {
+    return absl::InvalidArgumentError(
+        "sweep_output_prefix must be set to cluster with more than one "
+        "(mu, epsilon) pair");
+  }
 
-  const gbbs::indexed_scan::Clustering clustering{scan_index.Cluster(mu, epsilon)};
+  // Each clustering of the sweep is written as soon as it is computed, and
+  // only the one of the first (mu, epsilon) pair is kept.
+  std::optional<Clustering> ret;
+  RETURN_IF_ERROR(ClusterAll(
+      config, [&](int64_t mu, float epsilon, Clustering&& clustering) {
+        absl::Status status;
+        if (!output_prefix.empty()) {
+          std::cout << "mu = " << mu << ", epsilon = " << epsilon
+                    << ": Num clusters = " << clustering.size() << std::endl;
+          status = WriteClustering(SweepFilename(output_prefix, mu, epsilon),
+                                   clustering);
+        }
+        if (!ret.has_value() && mu == parameters.mus[0] &&
+            epsilon == parameters.epsilons[0]) {
+          ret = std::move(clustering);
+        }
+        return status;
+      }));
 
-  auto ret = research_graph::DenseClusteringToNestedClustering<gbbs::uintE>(clustering);
-  std::cout << "Num clusters = " << ret.size() << std::endl;
-  return ret;
+  std::cout << "Num clusters = " << ret->size() << std::endl;
+  return *std::move(ret);
 }
 
 }  // namespace in_memory
@@ -16,10 +16,13 @@
 #define PARALLEL_CLUSTERING_CLUSTERERS_SCAN_CLUSTERER_H_
 
 #include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <iterator>
 #include <utility>
 #include <vector>
 
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "parcluster/api/config.pb.h"
 #include "parcluster/api/gbbs-graph.h"
@@ -34,9 +37,21 @@ class ScanClusterer : public InMemoryClusterer {
  public:
   Graph* MutableGraph() override { return &graph_; }
 
+  // Returns the clustering of the first (mu, epsilon) pair of the
+  // ScanClustererConfig in `config`, and writes the clusterings of all pairs if
+  // `sweep_output_prefix` is set.
   absl::StatusOr<Clustering> Cluster(
       const ClustererConfig& config) const override;
 
+  // Runs f(mu, epsilon, <clustering with parameters (mu, epsilon)>) for every
+  // (mu, epsilon) pair of the ScanClustererConfig in `config`, from a SCAN
+  // index built once for all of them. f is called sequentially, by mu as
+  // listed but in arbitrary epsilon order, and only one clustering is held at
+  // a time. Stops at and returns the first error of f.
+  absl::Status ClusterAll(
+      const ClustererConfig& config,
+      const std::function<absl::Status(int64_t, float, Clustering&&)>& f) const;
+
  private:
   GbbsGraph graph_;
 };
@@ -7,6 +7,7 @@
 #include <random>
 #include <map>
 
+#include "clusterers/heaviest-label.h"
 #include "clusterers/slpa_clusterer/slpa_config.pb.h"
 
 #include "absl/status/statusor.h"
@@ -21,71 +22,131 @@
 namespace research_graph {
 namespace in_memory {
 
+namespace {
 
-
-gbbs::uintE speak_sequential(const gbbs::uintE v, const std::map<gbbs::uintE, std::size_t>& memory, const std::size_t m, int seed){
-    // std::random_device rd;
-    // std::mt19937 gen(seed);
-    // std::uniform_int_distribution<size_t> dist(0, m - 1);
-    // size_t rnd = dist(gen);
+// Returns the label spoken by `v` in the round where every memory has size
+// `m`. The label is drawn with probability proportional to its count by a
+// binary search over the cumulative counts of `memory`.
+gbbs::uintE speak_sequential(const gbbs::uintE v, const SLPAClusterer::LabelMemory& memory, const std::size_t m, int seed){
     size_t rnd = parlay::hash64(seed + static_cast<std::size_t>(v) + m) % m;
-    // std::cout << "speaker: " << v << "\n";
-    // std::cout << "rnd: " << rnd << "\n";
-    // std::cout << "m: " << m << "\n";
-
-    for (const auto& kv : memory) {
-        if (rnd < kv.second){
-            // std::cout << " return: k " << kv.first << " v " << kv.second << "\n";
-            return kv.first;
-        }
-        rnd -= kv.second;
-    }
-    return 0; // should never reach this line
+    auto it = std::upper_bound(
+        memory.begin(), memory.end(), rnd,
+        [](std::size_t r, const std::pair<gbbs::uintE, gbbs::uintE>& p) {
+          return r < p.second;
+        });
+    return it->first;
 }
 
-SLPAClusterer::Clustering SLPAClusterer::findMaximalSets(std::vector<std::set<gbbs::uintE>>& sets) const {
-    std::vector<bool> flags(sets.size(), true);
-    parlay::parallel_for(0, sets.size(), [&](size_t i){
+// Writes `memory` with one more occurrence of `label` to `next`, reusing the
+// storage of `next`.
+void Remember(const SLPAClusterer::LabelMemory& memory, gbbs::uintE label,
+              SLPAClusterer::LabelMemory* next) {
+  next->assign(memory.begin(), memory.end());
+  auto it = std::lower_bound(
+      next->begin(), next->end(), label,
+      [](const std::pair<gbbs::uintE, gbbs::uintE>& p, gbbs::uintE l) {
+        return p.first < l;
+      });
+  if (it == next->end() || it->first != label) {
+    gbbs::uintE previous = it == next->begin() ? 0 : std::prev(it)->second;
+    it = next->insert(it, std::make_pair(label, previous));
+  }
+  for (; it != next->end(); ++it) it->second++;
+}
+
+// Returns the sets in `sets` that are not contained in another set, in input
+// order. Of several equal sets, only the first is kept. Every set must be
+// sorted.
+//
+// Only the sets containing the rarest member of a set can contain the set, so
+// each set is tested only against the posting list of its rarest member.
+SLPAClusterer::Clustering MaximalSets(const SLPAClusterer::Clustering& sets) {
+  using NodeId = InMemoryClusterer::NodeId;
+  std::size_t num_sets = sets.size();
+  if (num_sets == 0) return SLPAClusterer::Clustering();
+
+  // (member, set id) pairs sorted by member: the posting lists of all members,
+  // stored consecutively.
+  auto offsets = parlay::sequence<std::size_t>::from_function(
+      num_sets, [&](std::size_t i) { return sets[i].size(); });
+  std::size_t num_postings = parlay::scan_inplace(offsets);
+  auto postings =
+      parlay::sequence<std::pair<NodeId, std::size_t>>::uninitialized(
+          num_postings);
+  parlay::parallel_for(0, num_sets, [&](std::size_t i) {
+    for (std::size_t j = 0; j < sets[i].size(); ++j) {
+      postings[offsets[i] + j] = std::make_pair(sets[i][j], i);
+    }
+  });
+  parlay::sort_inplace(postings);
+
+  auto posting_list = [&](NodeId member) {
+    auto first = std::lower_bound(
+        postings.begin(), postings.end(), member,
+        [](const std::pair<NodeId, std::size_t>& p, NodeId m) {
+          return p.first < m;
+        });
+    auto last = std::upper_bound(
+        first, postings.end(), member,
+        [](NodeId m, const std::pair<NodeId, std::size_t>& p) {
+          return m < p.first;
+        });
+    return parlay::make_slice(first, last);
+  };
+
+  auto is_maximal = parlay::sequence<bool>::from_function(
+      num_sets, [&](std::size_t i) {
         const auto& set = sets[i];
-        bool isMaximal = true;
-        // parlay::parallel_for(0, sets.size(), [&](size_t j){
-        //     if (isMaximal && i != j){
-        //       //
-        //       const auto& otherSet = sets[j];
-        //       if(std::includes(otherSet.begin(), otherSet.end(), set.begin(), set.end())) {
-        //         if (set.size() == otherSet.size()){ // same set
-        //           isMaximal = i < j;
-        //         } else {
-        //           isMaximal = false;
-        //         }
-        //       }
-        //     }
-        // });
-        for (size_t j = 0; j < sets.size(); ++j) {
-            if (i != j) {
-                const auto& otherSet = sets[j];
-                if(std::includes(otherSet.begin(), otherSet.end(), set.begin(), set.end())) {
-                    if (set.size() == otherSet.size()) { // same set
-                        isMaximal = i < j;
-                    } else {
-                        isMaximal = false;
-                    }
-                    if (!isMaximal) break;
-                }
-            }
+        // The empty set is contained in every set.
+        if (set.empty()) return i == 0 && num_postings == 0;
+
+        auto candidates = posting_list(set[0]);
+        for (std::size_t j = 1; j < set.size(); ++j) {
+          auto list = posting_list(set[j]);
+          if (list.size() < candidates.size()) candidates = list;
         }
-        flags[i] = isMaximal;
-    });
-    SLPAClusterer::Clustering maximalSets;
-    for (int i=0;i<sets.size();++i){
-      if(flags[i]) {
-          maximalSets.push_back(std::vector<gbbs::uintE>(sets[i].begin(), sets[i].end()));
+        for (const auto& [member, j] : candidates) {
+          const auto& other_set = sets[j];
+          if (j == i || other_set.size() < set.size()) continue;
+          if (std::includes(other_set.begin(), other_set.end(), set.begin(),
+                            set.end()) &&
+              (other_set.size() > set.size() || j < i)) {
+            return false;
+          }
         }
+        return true;
+      });
+
+  auto maximal_sets = parlay::pack(sets, is_maximal);
+  return SLPAClusterer::Clustering(maximal_sets.begin(), maximal_sets.end());
+}
+
+// Returns the most frequent label in `memory`, the smallest one on ties.
+gbbs::uintE TopLabel(const SLPAClusterer::LabelMemory& memory) {
+  gbbs::uintE top = memory[0].first;
+  gbbs::uintE top_count = 0;
+  gbbs::uintE previous = 0;
+  for (const auto& [label, cumulative_count] : memory) {
+    if (cumulative_count - previous > top_count) {
+      top = label;
+      top_count = cumulative_count - previous;
     }
-    return maximalSets;
+    previous = cumulative_count;
+  }
+  return top;
 }
 
-SLPAClusterer::Clustering SLPAClusterer::postprocessing(const parlay::sequence<std::map<gbbs::uintE, size_t>>& memory, bool remove_nested, double prune_threshold, int total_n) const {
+}  // namespace
+
+SLPAClusterer::Clustering SLPAClusterer::findMaximalSets(std::vector<std::set<gbbs::uintE>>& sets) const {
+  SLPAClusterer::Clustering sorted_sets(sets.size());
+  parlay::parallel_for(0, sets.size(), [&](std::size_t i) {
+    sorted_sets[i].assign(sets[i].begin(), sets[i].end());
+  });
+  return MaximalSets(sorted_sets);
+}
+
+SLPAClusterer::Clustering SLPAClusterer::postprocessing(const parlay::sequence<LabelMemory>& memory, bool remove_nested, double prune_threshold, int total_n) const {
   std::size_t n = memory.size();
   parlay::sequence<std::vector<std::pair<gbbs::uintE, gbbs::uintE>>> labels(n);
   parlay::parallel_for(0, n, [&] (size_t i) {
@@ -94,8 +155,10 @@ SLPAClusterer::Clustering SLPAClusterer::postprocessing(const parlay::sequence<s
     //   total += kv.second;
     // }
     // assert(total == total_n);
+    gbbs::uintE previous = 0;
     for(const auto& kv: memory[i]){
-      if(kv.second > prune_threshold * total_n) labels[i].push_back({kv.first, i});
+      if(kv.second - previous > prune_threshold * total_n) labels[i].push_back({kv.first, i});
+      previous = kv.second;
     }
     // if (labels[i].size() > 1){
     //   std::cout << "label size larger than 1\n";
@@ -116,88 +179,50 @@ SLPAClusterer::Clustering SLPAClusterer::postprocessing(const parlay::sequence<s
   //   ret[i] = std::vector(grouped.second.begin(), grouped.second.end());
   // });
 
-  if(remove_nested && prune_threshold <= 0.5){ // impossible to have nested cluster if prune_threshold >0.5
-    std::vector<std::set<gbbs::uintE>> sets;
-    for (std::size_t i=0; i<pairs.size(); i++) {
-      auto& cluster_i = pairs[i].first;
-      if (i == 0 || cluster_i != pairs[i-1].first) {
-        sets.emplace_back(std::set<gbbs::uintE>{pairs[i].second});
-      } else {
-        sets[sets.size()-1].insert(pairs[i].second);
-      }
-    }
-
-    std::cout << "Num. clusters before removing: " << sets.size() << std::endl;
-    
-    output = findMaximalSets(sets);
-    
-  } else {
-    // for (std::size_t i=0; i<pairs.size(); i++) {
-    //   auto& cluster_i = pairs[i].first;
-    //   if (i == 0 || cluster_i != pairs[i-1].first) {
-    //     output.emplace_back(std::vector<gbbs::uintE>{pairs[i].second});
-    //   } else {
-    //     output[output.size()-1].emplace_back(pairs[i].second);
-    //   }
-    // }
-    // std::cout << "[ ";
-    // for (const auto& p : pairs) {
-    //     std::cout << "(" << p.first << ", " << p.second << ") ";
-    // }
-    // std::cout << "]" << std::endl;
-
-    std::size_t n = pairs.size();
-    parlay::sequence<int>prefix_sums(n, 0);
-
-    // 1. Compute the binary prefix_sums array.
-    parlay::parallel_for(1, n, [&](std::size_t i) {
-        if (pairs[i].first != pairs[i-1].first) {
-            prefix_sums[i] = 1;
-        }
-    });
-    prefix_sums[0] = 1; // The first cluster always starts a new sequence.
+  if (pairs.empty()) return output;
 
-    // 2. Compute the prefix sum.
-    parlay::scan_inclusive_inplace(prefix_sums);
-    prefix_sums.push_back(prefix_sums[n-1]+1);
+  std::size_t num_pairs = pairs.size();
+  parlay::sequence<int>prefix_sums(num_pairs, 0);
 
-    // std::cout << "[ ";
-    // for (const auto& elem : prefix_sums) {
-    //     std::cout << elem << " ";
-    // }
-    // std::cout << "]" << std::endl;
-
-    // 3. Allocate space for the output.
-    output.resize(prefix_sums[n-1]); // Total number of unique clusters.
-    parlay::sequence<int> start_ids(prefix_sums[n]);
+  // 1. Compute the binary prefix_sums array.
+  parlay::parallel_for(1, num_pairs, [&](std::size_t i) {
+      if (pairs[i].first != pairs[i-1].first) {
+          prefix_sums[i] = 1;
+      }
+  });
+  prefix_sums[0] = 1; // The first cluster always starts a new sequence.
 
-    // 4. Fill the output in parallel.
-    parlay::parallel_for(0, n, [&](std::size_t i) {
-        if (i==0 || prefix_sums[i] != prefix_sums[i-1]) {
-            start_ids[prefix_sums[i]] = i;
-        }
-    });
-    start_ids.push_back(n);
+  // 2. Compute the prefix sum.
+  parlay::scan_inclusive_inplace(prefix_sums);
+  prefix_sums.push_back(prefix_sums[num_pairs-1]+1);
 
-    // std::cout << "[ ";
-    // for (const auto& elem : start_ids) {
-    //     std::cout << elem << " ";
-    // }
-    // std::cout << "]" << std::endl;
-
-    parlay::parallel_for(0, n, [&](std::size_t i) {
-        std::size_t pos = prefix_sums[i] - 1;
-        if (i==0 || prefix_sums[i] != prefix_sums[i-1]) {
-            std::size_t start_point = start_ids[prefix_sums[i]];
-            std::size_t cluster_size = start_ids[prefix_sums[i]+1] - start_point;
-            output[pos].resize(cluster_size);
-            parlay::parallel_for(0, cluster_size, [&](std::size_t j){
-              output[pos][j] = pairs[start_point + j].second;
-            });
-        }
-    });
+  // 3. Allocate space for the output.
+  output.resize(prefix_sums[num_pairs-1]); // Total number of unique clusters.
+  parlay::sequence<int> start_ids(prefix_sums[num_pairs]);
 
+  // 4. Fill the output in parallel. Members end up sorted by node id.
+  parlay::parallel_for(0, num_pairs, [&](std::size_t i) {
+      if (i==0 || prefix_sums[i] != prefix_sums[i-1]) {
+          start_ids[prefix_sums[i]] = i;
+      }
+  });
+  start_ids.push_back(num_pairs);
+
+  parlay::parallel_for(0, num_pairs, [&](std::size_t i) {
+      std::size_t pos = prefix_sums[i] - 1;
+      if (i==0 || prefix_sums[i] != prefix_sums[i-1]) {
+          std::size_t start_point = start_ids[prefix_sums[i]];
+          std::size_t cluster_size = start_ids[prefix_sums[i]+1] - start_point;
+          output[pos].resize(cluster_size);
+          parlay::parallel_for(0, cluster_size, [&](std::size_t j){
+            output[pos][j] = pairs[start_point + j].second;
+          });
+      }
+  });
 
+  if(remove_nested && prune_threshold <= 0.5){ // impossible to have nested cluster if prune_threshold >0.5
+    std::cout << "Num. clusters before removing: " << output.size() << std::endl;
+    output = MaximalSets(output);
   }
   return output;
 }
@@ -213,29 +238,45 @@ SLPAClusterer::Cluster(const ClustererConfig& config) const {
   gbbs::uintE par_threshold = slpa_config.par_threshold();
   double prune_threshold = slpa_config.prune_threshold();
   bool remove_nested = slpa_config.remove_nested();
+  double convergence_threshold = slpa_config.convergence_threshold();
+  int convergence_window = slpa_config.convergence_window();
+  bool trace_iterations = slpa_config.trace_iterations();
 
   std::cout << "max_iteration: " << max_iteration << std::endl;
   std::cout << "par_threshold: " << par_threshold << std::endl;
   std::cout << "prune_threshold: " << prune_threshold << std::endl;
   std::cout << "remove_nested: " << (remove_nested ? "true" : "false") << std::endl;
+  std::cout << "convergence_threshold: " << convergence_threshold << std::endl;
+  std::cout << "convergence_window: " << convergence_window << std::endl;
+
+  if (convergence_window < 1) {
+    return absl::FailedPreconditionError("convergence_window must be positive");
+  }
 
   int seed = slpa_config.seed();
 
-  auto memory = parlay::sequence<std::map<gbbs::uintE, size_t>>::from_function(n, [&] (size_t i) { return std::map<gbbs::uintE, size_t>{{i, 1}}; });
-  
-  for (int n_iterations = 0; n_iterations < max_iteration; n_iterations++) {
-      // std::cout << "Round " << n_iterations << std::endl;
+  // Listeners read the memories of the previous round from `memory` and write
+  // their own updated memory to `next_memory`, so that no memory is modified
+  // while a neighbor may be speaking from it.
+  auto memory = parlay::sequence<LabelMemory>::from_function(n, [&] (size_t i) { return LabelMemory{std::make_pair(static_cast<gbbs::uintE>(i), gbbs::uintE{1})}; });
+  auto next_memory = parlay::sequence<LabelMemory>(n);
+
+  // Most frequent label of every memory, and whether it changed in the last
+  // round.
+  auto top_labels = parlay::sequence<gbbs::uintE>::from_function(n, [&] (size_t i) { return i; });
+  auto top_label_changed = parlay::sequence<bool>(n, false);
 
+  int n_iterations = 0;
+  int n_stable_iterations = 0;
+  while (n_iterations < max_iteration) {
     parlay::parallel_for(0, n, [&] (gbbs::uintE node_id) {
       // auto node_id = active_nodes[i];
 
-      // std::cout << "Node " << node_id << std::endl;
       auto degree =  graph_.Graph()->get_vertex(node_id).out_degree();
       gbbs::uintE heaviest;
       if(degree == 0){
           heaviest = node_id;
-      } else {
-      // } else if(degree < par_threshold){
+      } else if(degree < par_threshold){
           // neighborLabelCounts maps label -> frequency in the neighbors
           std::map<gbbs::uintE, double> label_weights_sum;
           auto listen_f = [&] (const auto& u, const auto& v, const auto& wgh) {
@@ -244,46 +285,43 @@ SLPAClusterer::Cluster(const ClustererConfig& config) const {
           };
           graph_.Graph()->get_vertex(node_id).out_neighbors().map(listen_f, false);
 
-          // std::cout << " label_weights_sum: \n";
-          // for(auto [v, w]: label_weights_sum){
-          //   std::cout << v << " " << w << "\n";
-          // }
-
-          heaviest = std::max_element(label_weights_sum.begin(), label_weights_sum.end(),
-                                                  [](const std::pair<gbbs::uintE, double> &p1,
-                                                    const std::pair<gbbs::uintE, double> &p2) {
-                                                      return p1.second < p2.second || (p1.second == p2.second && p1.first < p2.first);
-                                                  })
-                                    ->first;
-      // } else {
-      //   auto neighbors = graph_.Graph()->get_vertex(node_id).out_neighbors();
-
-      //   auto label_weights = parlay::delayed_seq<std::pair<gbbs::uintE, double>>(degree, [&](size_t i){
-      //     auto [v, w] = neighbors.get_ith_neighbor(i);
-      //     auto label = speak_sequential(v, memory[v], n_iterations + 1, seed);
-      //     return std::make_pair(label, w);
-      //   });
-
-      //   auto grouped = parlay::group_by_key(label_weights);
-      //   auto label_weights_sum = parlay::sequence<std::pair<double, gbbs::uintE>>(grouped.size());
-      //   parlay::parallel_for(0, grouped.size(), [&](gbbs::uintE i){
-      //     auto cluster_id = grouped[i].first;
-      //     auto w = parlay::reduce(grouped[i].second);
-      //     label_weights_sum[i] = {w, cluster_id};
-      //   });
-
-      //   heaviest = parlay::max_element(label_weights_sum)->second;
+          heaviest = HeaviestLabel(label_weights_sum);
+      } else {
+        // High-degree listener: collect the spoken labels in parallel and sum
+        // the weights per label with a parallel reduction.
+        auto label_weights = parlay::sequence<std::pair<gbbs::uintE, double>>::uninitialized(degree);
+        auto listen_f = [&] (const auto& u, const auto& v, const auto& wgh, const auto& j) {
+          auto label = speak_sequential(v, memory[v], n_iterations + 1, seed);
+          label_weights[j] = std::make_pair(label, static_cast<double>(wgh));
+        };
+        graph_.Graph()->get_vertex(node_id).out_neighbors().map_with_index(listen_f);
+        heaviest = HeaviestLabel(parlay::reduce_by_key(label_weights));
       }
 
-      // std::cout << "node_id " << node_id << " heaviest " << heaviest << "\n";
-      memory[node_id][heaviest]++;
+      Remember(memory[node_id], heaviest, &next_memory[node_id]);
+      auto top_label = TopLabel(next_memory[node_id]);
+      top_label_changed[node_id] = top_label != top_labels[node_id];
+      top_labels[node_id] = top_label;
     });
-
-
-    } // end for loop
-  std::cout << "Num iterations: " << max_iteration << std::endl;
+    std::swap(memory, next_memory);
+    n_iterations++;
+
+    std::size_t n_changed = parlay::count(top_label_changed, true);
+    double changed_fraction = n == 0 ? 0 : static_cast<double>(n_changed) / n;
+    if (trace_iterations) {
+      std::cout << "Iteration " << n_iterations << ": top label changed for "
+                << n_changed << " nodes (" << changed_fraction << ")" << std::endl;
+    }
+    if (convergence_threshold >= 0 && changed_fraction <= convergence_threshold) {
+      n_stable_iterations++;
+      if (n_stable_iterations >= convergence_window) break;
+    } else {
+      n_stable_iterations = 0;
+    }
+  } // end while
+  std::cout << "Num iterations: " << n_iterations << std::endl;
   std::cout << "postprocessing" << "\n";
-  auto output = postprocessing(memory, remove_nested, prune_threshold, max_iteration + 1);
+  auto output = postprocessing(memory, remove_nested, prune_threshold, n_iterations + 1);
 
   std::cout << "Num clusters = " << output.size() << std::endl;
   return output;
@@ -32,6 +32,11 @@ namespace in_memory {
 
 class SLPAClusterer : public InMemoryClusterer {
  public:
+  // Label memory of a node: (label, cumulative count) pairs sorted by label,
+  // where the cumulative count of a label is the total count of the labels up
+  // to and including it. The last entry holds the size of the memory.
+  using LabelMemory = std::vector<std::pair<gbbs::uintE, gbbs::uintE>>;
+
   Graph* MutableGraph() override { return &graph_; }
 
   absl::StatusOr<Clustering> Cluster(
@@ -42,7 +47,7 @@ class SLPAClusterer : public InMemoryClusterer {
   // Postprocess `memory` and return clustering. If `remove_nested` is true, nested communities are removed. labels appears with probability less than 
   // `prune_threshold` are removed from each map in `memory`.
   // `memory[i]` contains the memory of node `i`. 
-  Clustering postprocessing(const parlay::sequence<std::map<gbbs::uintE, size_t>>& memory, bool remove_nested,
+  Clustering postprocessing(const parlay::sequence<LabelMemory>& memory, bool remove_nested,
                             double prune_threshold, int total_n) const;
 
  private:
@@ -21,7 +21,7 @@
 #include "parcluster/api/in-memory-clusterer-base.h"
 #include "parcluster/api/status_macros.h"
 
-#include "parlay/hash_table.h"
+#include "clusterers/stats/stats_contingency.h"
 
 namespace research_graph::in_memory {
 
@@ -29,105 +29,30 @@ namespace {
 inline std::size_t nChoose2(std::size_t x) {
   return x * (x - 1) / 2 ;
 }
-
-// Example for hashing numeric values.
-// T must be some integer type
-template <class T>
-struct hash_numeric_unsigned {
-  using eType = T;
-  using kType = T;
-  eType empty() { return std::numeric_limits<T>::max(); }
-  kType getKey(eType v) { return v; }
-  size_t hash(kType v) { return static_cast<size_t>(parlay::hash64(v)); }
-  int cmp(kType v, kType b) { return (v > b) ? 1 : ((v == b) ? 0 : -1); }
-  bool replaceQ(eType, eType) { return 0; }
-  eType update(eType v, eType) { return v; }
-  bool cas(eType* p, eType o, eType n) {
-    // TODO: Make this use atomics properly. This is a quick
-    // fix to get around the fact that the hashtable does
-    // not use atomics. This will break for types that
-    // do not inline perfectly inside a std::atomic (i.e.,
-    // any type that the standard library chooses to lock)
-    return std::atomic_compare_exchange_strong_explicit(
-      reinterpret_cast<std::atomic<eType>*>(p), &o, n, std::memory_order_relaxed, std::memory_order_relaxed);
-  }
-};
-
 }
 
-// we only need the n choose 2 values of all contingency matrix values
-// do not need store all of them
+// we only need the n choose 2 values of all contingency matrix values,
+// which are read off the sparse contingency table `table`
 // only works for non-overlapping clustering
 inline absl::Status ComputeARI(
-  const size_t n,
-  const InMemoryClusterer::Clustering& clustering, ClusteringStatistics* clustering_stats,
-  const InMemoryClusterer::Clustering& ground_truth,
+  const size_t n, const ContingencyTable& table,
+  ClusteringStatistics* clustering_stats,
   const ClusteringStatsConfig& clustering_stats_config){
     const bool compute_ari = clustering_stats_config.compute_ari();
   if (!compute_ari) {
     return absl::OkStatus();
   }
 
+  size_t nChoose2ContingencySum = parlay::reduce(
+    parlay::delayed_seq<std::size_t>(table.cells.size(), [&](std::size_t i){
+      return nChoose2(std::get<2>(table.cells[i]));
+  }));
 
-
-  size_t num_cluster_1 = clustering.size();
-  size_t num_cluster_2 = ground_truth.size();
-
-  parlay::sequence<std::atomic<std::size_t> > row_sums(num_cluster_1); //  sums for clustering
-  parlay::sequence<std::atomic<std::size_t> > column_sums(num_cluster_2); //  sums for ground_truth
-
-
-  using tableT = parlay::hashtable<hash_numeric_unsigned <gbbs::uintE> >;
-
-  auto empty_val = hash_numeric_unsigned <gbbs::uintE>().empty();
-
-  std::vector<tableT*> tables1(num_cluster_1);
-  std::vector<tableT*> tables2(num_cluster_2);
-  parlay::parallel_for(0, num_cluster_1, [&](size_t i){
-    row_sums[i].store(0);
-    tables1[i] = new tableT(clustering[i].size(), hash_numeric_unsigned<gbbs::uintE>{});
-    parlay::parallel_for(0, clustering[i].size(), [&](size_t j){
-    tables1[i]->insert(clustering[i][j]);
-    });
+  auto row_n_choose_2_values = parlay::delayed_seq<std::size_t>(table.row_sums.size(), [&](std::size_t i){
+    return nChoose2(table.row_sums[i]);
   });
-  parlay::parallel_for(0, num_cluster_2, [&](size_t i){
-    column_sums[i].store(0);
-    tables2[i] = new tableT(ground_truth[i].size(), hash_numeric_unsigned<gbbs::uintE>{});
-    parlay::parallel_for(0, ground_truth[i].size(), [&](size_t j){
-    tables2[i]->insert(ground_truth[i][j]);
-    });
-  });
-
-  std::atomic<size_t> nChoose2ContingencySum;
-  nChoose2ContingencySum.store(0);
-  // linear time output two cluster ids, and use a group by
-  parlay::parallel_for(0, num_cluster_1, [&](size_t i){
-  parlay::parallel_for(0, num_cluster_2, [&](size_t j){
-    size_t val = 0;
-
-    if(clustering[i].size() < ground_truth[j].size()){
-      auto flags = parlay::delayed_seq<std::size_t>(clustering[i].size(), [&](size_t k){
-        return tables2[j]->find(clustering[i][k]) == empty_val? 0 : 1 ; // find clustering's id in table2
-      });
-      val = parlay::reduce(flags);
-    }else{
-      auto flags = parlay::delayed_seq<std::size_t>(ground_truth[j].size(), [&](size_t k){
-        return tables1[i]->find(ground_truth[j][k]) == empty_val? 0 : 1 ;
-      });
-      val = parlay::reduce(flags);
-    }
-    parlay::write_add(&nChoose2ContingencySum, nChoose2(val));
-
-    parlay::write_add(&(row_sums[i]), val);
-    parlay::write_add(&(column_sums[j]), val);
-  });
-  });
-  
-  auto row_n_choose_2_values = parlay::delayed_seq<std::size_t>(row_sums.size(), [&](std::size_t i){
-    return nChoose2(row_sums[i].load());
-  });
-   auto column_n_choose_2_values = parlay::delayed_seq<std::size_t>(column_sums.size(), [&](std::size_t i){
-    return nChoose2(column_sums[i].load());
+   auto column_n_choose_2_values = parlay::delayed_seq<std::size_t>(table.column_sums.size(), [&](std::size_t i){
+    return nChoose2(table.column_sums[i]);
   });
 
   size_t nChoose2RowSum = parlay::reduce(row_n_choose_2_values);
@@ -164,17 +89,63 @@ inline absl::Status ComputeARI(
   
   clustering_stats->set_ari(ariValue);
 
-  parlay::parallel_for(0, num_cluster_1, [&](size_t i){
-    delete tables1[i];
-  });
+  return absl::OkStatus();
+}
+
+// Pair-counting precision and recall: a pair of vertices is a true positive if
+// it is in the same cluster and in the same community. The pair counts are the
+// n choose 2 sums of the contingency table `table`, as for ARI.
+inline absl::Status ComputePairPrecisionRecall(
+  const ContingencyTable& table, ClusteringStatistics* clustering_stats,
+  const ClusteringStatsConfig& clustering_stats_config){
+  if (!clustering_stats_config.compute_pair_precision_recall()) {
+    return absl::OkStatus();
+  }
 
-  parlay::parallel_for(0, num_cluster_2, [&](size_t i){
-    delete tables2[i];
+  auto n_choose_2_sum = [](std::size_t size, auto&& count) {
+    return parlay::reduce(parlay::delayed_seq<std::size_t>(size, [&](std::size_t i){
+      return nChoose2(count(i));
+    }));
+  };
+  size_t true_positives = n_choose_2_sum(table.cells.size(), [&](std::size_t i){
+    return std::get<2>(table.cells[i]);
+  });
+  size_t clustered_pairs = n_choose_2_sum(table.row_sums.size(), [&](std::size_t i){
+    return table.row_sums[i];
+  });
+  size_t community_pairs = n_choose_2_sum(table.column_sums.size(), [&](std::size_t i){
+    return table.column_sums[i];
   });
 
+  const double f_score = clustering_stats_config.f_score_param() != 0 ? clustering_stats_config.f_score_param() : 1;
+  double precision = clustered_pairs == 0 ? 0 : (double) true_positives / clustered_pairs;
+  double recall = community_pairs == 0 ? 0 : (double) true_positives / community_pairs;
+  double pair_f_score = (precision == 0 || recall == 0) ? 0 :
+    (1 + f_score * f_score) * precision * recall / ((f_score * f_score * precision) + recall);
+
+  clustering_stats->set_pair_true_positives(true_positives);
+  clustering_stats->set_pair_false_positives(clustered_pairs - true_positives);
+  clustering_stats->set_pair_false_negatives(community_pairs - true_positives);
+  clustering_stats->set_pair_precision(precision);
+  clustering_stats->set_pair_recall(recall);
+  clustering_stats->set_pair_f_score(pair_f_score);
+  clustering_stats->set_f_score_param(f_score);
+
   return absl::OkStatus();
 }
 
+inline absl::Status ComputeARI(
+  const size_t n,
+  const InMemoryClusterer::Clustering& clustering, ClusteringStatistics* clustering_stats,
+  const InMemoryClusterer::Clustering& ground_truth,
+  const ClusteringStatsConfig& clustering_stats_config){
+  if (!clustering_stats_config.compute_ari()) {
+    return absl::OkStatus();
+  }
+  return ComputeARI(n, ComputeContingencyTable(clustering, ground_truth),
+                    clustering_stats, clustering_stats_config);
+}
+
 }  // namespace research_graph::in_memory
 
 #endif
\ No newline at end of file
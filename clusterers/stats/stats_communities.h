@@ -50,11 +50,9 @@ inline absl::Status CompareCommunities(std::vector<std::vector<gbbs::uintE>>& co
   const double f_score = clustering_stats_config.f_score_param() != 0 ? clustering_stats_config.f_score_param() : 1;
   clustering_stats->set_f_score_param(f_score);
 
-  auto clustering = clustering_;
-  // Pre-sort clusters to optimize the inner loop
-  for (auto& cluster : clustering) {
-    std::sort(cluster.begin(), cluster.end());
-  }
+  // Inverted index from each vertex to the clusters containing it, so that
+  // each community is only compared with the clusters of its members
+  auto cluster_index = ClustersByVertex(clustering_);
 
   // precision = num correct results (matches b/w clustering and comm) / num returned results (in clustering)
   // recall = num correct results (matches b/w clustering and comm) / num relevant results (in comm)
@@ -64,51 +62,26 @@ inline absl::Status CompareCommunities(std::vector<std::vector<gbbs::uintE>>& co
     communities.size(), [](std::size_t i){return 0;});
   parlay::sequence<double> f_score_vec = parlay::sequence<double>::from_function(
     communities.size(), [](std::size_t i){return 0;});
-  /*parlay::parallel_for(0, clustering.size(), [&](std::size_t i) {
-    auto cluster = clustering[i];
-    std::sort(cluster.begin(), cluster.end());
-  });*/
   parlay::parallel_for(0, communities.size(), [&](std::size_t j) {
-    auto community = communities[j];
-    std::sort(community.begin(), community.end());
-
-    std::size_t max_intersect = 0;
-    std::size_t max_idx = 0;
-    if (communities.size() > 30) {
-      std::vector<gbbs::uintE> intersect(community.size());
-      // Find the community in communities that has the greatest intersection with cluster
-      for (std::size_t i = 0; i < clustering.size(); i++) {
-        const auto& cluster = clustering[i];
-        auto it = std::set_intersection(cluster.begin(), cluster.end(), 
-          community.begin(), community.end(), intersect.begin());
-        std::size_t it_size = it - intersect.begin();
-
-        if (it_size > max_intersect) {
-          max_intersect = it_size;
-          max_idx = i;
-        }
-      }
-    }
-    else{
-      std::vector<std::size_t> intersections(clustering.size());
-      parlay::parallel_for(0, clustering.size(), [&](std::size_t i) {
-        const auto& cluster = clustering[i];
-        std::vector<gbbs::uintE> intersect(std::min(cluster.size(), community.size()));
-        auto it = std::set_intersection(cluster.begin(), cluster.end(), 
-          community.begin(), community.end(), intersect.begin());
-        std::size_t it_size = it - intersect.begin();
-        intersections[i] = it_size;
-      });
-        
-      max_intersect = intersections[0];
-      for (std::size_t i = 1; i < clustering.size(); ++i) {
-          if (intersections[i] > max_intersect) {
-              max_intersect = intersections[i];
-              max_idx = i;
-          }
-      }
-    }
-    precision_vec[j] = (double) max_intersect / (double) clustering[max_idx].size();
+    const auto& community = communities[j];
+
+    // Count the members of the community in each cluster that has any
+    auto member_clusters = parlay::flatten(parlay::delayed_seq<parlay::slice<const gbbs::uintE*, const gbbs::uintE*>>(
+      community.size(), [&](std::size_t k) { return cluster_index.Clusters(community[k]); }));
+    auto intersections = parlay::histogram_by_key(member_clusters);
+
+    // Find the cluster that has the greatest intersection with the community,
+    // preferring the lowest cluster index on ties
+    using Intersection = decltype(intersections)::value_type;
+    auto best = parlay::reduce(intersections, parlay::make_monoid(
+      [](const Intersection& a, const Intersection& b) {
+        if (a.second != b.second) return a.second > b.second ? a : b;
+        return a.first < b.first ? a : b;
+      }, Intersection{UINT_E_MAX, 0}));
+    std::size_t max_intersect = best.second;
+
+    precision_vec[j] = (max_intersect == 0) ? 0 :
+      (double) max_intersect / (double) clustering_[best.first].size();
     recall_vec[j] = (communities[j].size() == 0) ? 0 : 
       (double) max_intersect / (double) communities[j].size();
     f_score_vec[j] = (precision_vec[j] == 0 & recall_vec[j] == 0) ? 0:
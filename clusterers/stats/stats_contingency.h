@@ -0,0 +1,184 @@
+#pragma once
+#ifndef RESEARCH_GRAPH_IN_MEMORY_CLUSTERING_STATS_CONTINGENCY_H_
+#define RESEARCH_GRAPH_IN_MEMORY_CLUSTERING_STATS_CONTINGENCY_H_
+
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "clusterers/stats/stats_utils.h"
+#include "parcluster/api/gbbs-graph.h"
+#include "parcluster/api/in-memory-clusterer-base.h"
+
+namespace research_graph::in_memory {
+
+// Sparse contingency table between a clustering and the ground truth
+// communities. Only nonzero cells are stored.
+struct ContingencyTable {
+  // (cluster index, community index, number of shared vertices).
+  parlay::sequence<std::tuple<gbbs::uintE, gbbs::uintE, std::size_t>> cells;
+  // row_sums[i] is the number of memberships of the vertices of cluster i in
+  // communities, and column_sums[j] the number of memberships of the vertices
+  // of community j in clusters. Without overlaps, these are the numbers of
+  // vertices of cluster i in some community and of community j in some
+  // cluster.
+  parlay::sequence<std::size_t> row_sums;
+  parlay::sequence<std::size_t> column_sums;
+  // Sizes of the clusters and of the communities.
+  parlay::sequence<std::size_t> cluster_sizes;
+  parlay::sequence<std::size_t> community_sizes;
+};
+
+// Builds the contingency table in work linear in the number of memberships:
+// each vertex of a cluster emits one (cluster, community) pair per community
+// containing it, and the pairs are semisorted. Overlapping clusters or
+// communities count a vertex once in every cell it belongs to.
+inline ContingencyTable ComputeContingencyTable(
+    const InMemoryClusterer::Clustering& clustering,
+    const InMemoryClusterer::Clustering& ground_truth) {
+  auto communities_by_vertex = ClustersByVertex(ground_truth);
+
+  // The members of all clusters, as (cluster index, vertex) pairs.
+  auto offsets = parlay::sequence<std::size_t>::from_function(
+      clustering.size(), [&](std::size_t i) { return clustering[i].size(); });
+  std::size_t num_members = parlay::scan_inplace(offsets);
+  auto members =
+      parlay::sequence<std::pair<gbbs::uintE, gbbs::uintE>>::uninitialized(
+          num_members);
+  parlay::parallel_for(0, clustering.size(), [&](std::size_t i) {
+    parlay::parallel_for(0, clustering[i].size(), [&](std::size_t k) {
+      members[offsets[i] + k] =
+          std::make_pair(static_cast<gbbs::uintE>(i), clustering[i][k]);
+    });
+  });
+
+  // One key per (cluster, community) membership of each member, with the
+  // cluster index in the high bits and the community index in the low bits.
+  auto key_offsets = parlay::sequence<std::size_t>::from_function(
+      num_members, [&](std::size_t x) {
+        return communities_by_vertex.Clusters(members[x].second).size();
+      });
+  std::size_t num_keys = parlay::scan_inplace(key_offsets);
+  auto keys = parlay::sequence<uint64_t>::uninitialized(num_keys);
+  parlay::parallel_for(0, num_members, [&](std::size_t x) {
+    const auto& [i, v] = members[x];
+    auto communities = communities_by_vertex.Clusters(v);
+    for (std::size_t t = 0; t < communities.size(); t++) {
+      keys[key_offsets[x] + t] = (static_cast<uint64_t>(i) << 32) | communities[t];
+    }
+  });
+  auto counts = parlay::histogram_by_key(keys);
+
+  ContingencyTable table;
+  table.cells = parlay::map(counts, [](const auto& count) {
+    return std::make_tuple(static_cast<gbbs::uintE>(count.first >> 32),
+                           static_cast<gbbs::uintE>(count.first),
+                           static_cast<std::size_t>(count.second));
+  });
+  table.row_sums = parlay::reduce_by_index(
+      parlay::delayed_seq<std::pair<gbbs::uintE, std::size_t>>(
+          table.cells.size(),
+          [&](std::size_t c) {
+            return std::make_pair(std::get<0>(table.cells[c]),
+                                  std::get<2>(table.cells[c]));
+          }),
+      clustering.size(), parlay::addm<std::size_t>());
+  table.column_sums = parlay::reduce_by_index(
+      parlay::delayed_seq<std::pair<gbbs::uintE, std::size_t>>(
+          table.cells.size(),
+          [&](std::size_t c) {
+            return std::make_pair(std::get<1>(table.cells[c]),
+                                  std::get<2>(table.cells[c]));
+          }),
+      ground_truth.size(), parlay::addm<std::size_t>());
+  table.cluster_sizes = parlay::sequence<std::size_t>::from_function(
+      clustering.size(), [&](std::size_t i) { return clustering[i].size(); });
+  table.community_sizes = parlay::sequence<std::size_t>::from_function(
+      ground_truth.size(),
+      [&](std::size_t j) { return ground_truth[j].size(); });
+  return table;
+}
+
+// Returns the entropy in bits of the partition of n vertices into parts of
+// the given sizes.
+template <class Sizes>
+inline long double Entropy(const Sizes& sizes, const size_t n) {
+  return parlay::reduce(parlay::delayed_seq<long double>(
+      sizes.size(), [&](std::size_t i) -> long double {
+        long double proportion = ((long double)sizes[i]) / n;
+        if (proportion > 0) {
+          return -proportion * (log2l(sizes[i]) - log2l(n));
+        }
+        return 0;
+      }));
+}
+
+// Returns the conditional entropy in bits of the ground truth given the
+// clustering of `table`, or of the clustering given the ground truth if
+// `given_ground_truth`, over n vertices. `sizes` are the sizes of the parts
+// conditioned on.
+template <class Sizes>
+inline long double ConditionalEntropy(const ContingencyTable& table,
+                                      const Sizes& sizes, const size_t n,
+                                      const bool given_ground_truth = false) {
+  return parlay::reduce(parlay::delayed_seq<long double>(
+      table.cells.size(), [&](std::size_t c) -> long double {
+        const auto& [i, j, count] = table.cells[c];
+        std::size_t size = sizes[given_ground_truth ? j : i];
+        return -((long double)count) / n * (log2l(count) - log2l(size));
+      }));
+}
+
+// Returns the expected mutual information in bits between two random
+// partitions of n vertices with part sizes `sizes_1` and `sizes_2`, under the
+// hypergeometric model. Parts of equal size contribute equally, so each pair
+// of distinct sizes is evaluated once; as there are O(sqrt(n)) distinct sizes
+// per partition, this takes O(n^1.5) work at worst.
+template <class Sizes>
+inline long double ExpectedMutualInformation(const Sizes& sizes_1,
+                                             const Sizes& sizes_2,
+                                             const size_t n) {
+  // Returns the distinct nonzero sizes with their multiplicities.
+  auto size_counts = [](const Sizes& sizes) {
+    return parlay::filter(
+        parlay::histogram_by_key(parlay::delayed_seq<std::size_t>(
+            sizes.size(), [&](std::size_t i) { return sizes[i]; })),
+        [](const auto& size_count) { return size_count.first > 0; });
+  };
+  auto size_counts_1 = size_counts(sizes_1);
+  auto size_counts_2 = size_counts(sizes_2);
+
+  auto log_factorial = [](std::size_t x) -> long double {
+    return lgammal(x + 1) / logl(2);
+  };
+  long double log_n = log2l(n);
+  long double log_factorial_n = log_factorial(n);
+  return parlay::reduce(parlay::delayed_seq<long double>(
+      size_counts_1.size() * size_counts_2.size(),
+      [&](std::size_t p) -> long double {
+        const auto& [a, a_count] = size_counts_1[p / size_counts_2.size()];
+        const auto& [b, b_count] = size_counts_2[p % size_counts_2.size()];
+        if (a > n || b > n) return 0;
+        std::size_t first = a + b > n + 1 ? a + b - n : 1;
+        std::size_t last = std::min(a, b);
+        long double log_numerator = log_factorial(a) + log_factorial(b) +
+                                    log_factorial(n - a) +
+                                    log_factorial(n - b) - log_factorial_n;
+        long double sum = 0;
+        for (std::size_t k = first; k <= last; k++) {
+          long double log_probability =
+              log_numerator - log_factorial(k) - log_factorial(a - k) -
+              log_factorial(b - k) - log_factorial(n + k - a - b);
+          sum += ((long double)k) / n *
+                 (log2l(k) + log_n - log2l(a) - log2l(b)) *
+                 exp2l(log_probability);
+        }
+        return ((long double)a_count) * b_count * sum;
+      }));
+}
+
+}  // namespace research_graph::in_memory
+
+#endif  // RESEARCH_GRAPH_IN_MEMORY_CLUSTERING_STATS_CONTINGENCY_H_
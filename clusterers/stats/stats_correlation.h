@@ -6,6 +6,7 @@
 #include <iomanip>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/flags/flag.h"
@@ -25,109 +26,142 @@
 
 namespace research_graph::in_memory {
 
+// Edge weight sums from which the correlation and modularity objectives are
+// evaluated for any resolution and edge weight offset. Sums are over the
+// directed edges, so each undirected edge is counted twice, except self-loops.
+struct ObjectiveSums {
+  // Total weight of all edges.
+  double total_weight = 0;
+  // Total weight of the intra-cluster edges, including self-loops.
+  double intra_cluster_weight = 0;
+  // Total weight and number of the intra-cluster edges that are not
+  // self-loops.
+  double intra_cluster_pair_weight = 0;
+  std::size_t intra_cluster_pair_count = 0;
+  double self_loop_weight = 0;
+  // Sum over clusters of the squared total weighted degree of the cluster.
+  double squared_volume_sum = 0;
+  // Number of unordered vertex pairs within clusters.
+  double cluster_pair_count = 0;
+};
+
+// Computes the ObjectiveSums in one pass over the graph.
+inline ObjectiveSums ComputeObjectiveSums(const GbbsGraph& graph,
+  const InMemoryClusterer::Clustering& clustering, const parlay::sequence<gbbs::uintE>& cluster_ids) {
+  size_t n = graph.Graph()->n;
+  auto add_sums = parlay::make_monoid([](const ObjectiveSums& a, const ObjectiveSums& b) {
+    ObjectiveSums sums;
+    sums.total_weight = a.total_weight + b.total_weight;
+    sums.intra_cluster_weight = a.intra_cluster_weight + b.intra_cluster_weight;
+    sums.intra_cluster_pair_weight = a.intra_cluster_pair_weight + b.intra_cluster_pair_weight;
+    sums.intra_cluster_pair_count = a.intra_cluster_pair_count + b.intra_cluster_pair_count;
+    sums.self_loop_weight = a.self_loop_weight + b.self_loop_weight;
+    return sums;
+  }, ObjectiveSums());
+
+  // Contributions of the edges of each vertex; total_weight is its weighted
+  // degree. Edges of vertices outside `clustering` are in no cluster.
+  auto is_clustered = ClusteredVertices(n, clustering);
+  auto vertex_sums = parlay::sequence<ObjectiveSums>::from_function(n, [&](std::size_t i) {
+    auto map_f = [&](gbbs::uintE u, gbbs::uintE v, float weight) {
+      ObjectiveSums sums;
+      sums.total_weight = weight;
+      if (!is_clustered[u] || !is_clustered[v]) {
+        return sums;
+      } else if (u == v) {
+        sums.intra_cluster_weight = weight;
+        sums.self_loop_weight = weight;
+      } else if (cluster_ids[u] == cluster_ids[v]) {
+        sums.intra_cluster_weight = weight;
+        sums.intra_cluster_pair_weight = weight;
+        sums.intra_cluster_pair_count = 1;
+      }
+      return sums;
+    };
+    return graph.Graph()->get_vertex(i).out_neighbors().reduce(map_f, add_sums);
+  });
+  ObjectiveSums sums = parlay::reduce(vertex_sums, add_sums);
+
+  sums.squared_volume_sum = parlay::reduce(parlay::delayed_seq<double>(clustering.size(), [&](std::size_t i) {
+    double volume = parlay::reduce(parlay::delayed_seq<double>(clustering[i].size(), [&](std::size_t j) {
+      return vertex_sums[clustering[i][j]].total_weight;
+    }));
+    return volume * volume;
+  }));
+  sums.cluster_pair_count = parlay::reduce(parlay::delayed_seq<double>(clustering.size(), [&](std::size_t i) {
+    double cluster_weight = clustering[i].size();
+    return cluster_weight * (cluster_weight - 1) / 2;
+  }));
+  return sums;
+}
+
+// Correlation clustering objective for each pair of resolution and edge weight
+// offset in the config. Each intra-cluster edge contributes its weight minus
+// the offset, and self-loops their weight, while each pair of vertices in the
+// same cluster costs the resolution. `sums` is
+// ComputeObjectiveSums(graph, clustering, cluster_ids).
 inline absl::Status ComputeCorrelationObjective(const GbbsGraph& graph, 
   const InMemoryClusterer::Clustering& clustering, ClusteringStatistics* clustering_stats,
-  const parlay::sequence<gbbs::uintE>& cluster_ids, const ClusteringStatsConfig& clustering_stats_config) {
+  const parlay::sequence<gbbs::uintE>& cluster_ids, const ClusteringStatsConfig& clustering_stats_config,
+  const ObjectiveSums& sums) {
   const google::protobuf::RepeatedField<double>& edge_weight_offset = clustering_stats_config.correlation_edge_weight_offsets();
   const google::protobuf::RepeatedField<double>& resolution = clustering_stats_config.correlation_resolutions();
-  size_t n = graph.Graph()->n;
   assert(edge_weight_offset.size() == resolution.size());
-  parlay::sequence<double> shifted_edge_weight(n);
 
   for(size_t k = 0; k < edge_weight_offset.size(); k++){
-    // Compute cluster statistics contributions of each vertex
-    parlay::parallel_for(0, n, [&](std::size_t i) {
-      gbbs::uintE cluster_id_i = cluster_ids[i];
-      auto add_m = parlay::addm<double>();
-
-      auto intra_cluster_sum_map_f = [&](gbbs::uintE u, gbbs::uintE v,
-                                         float weight) -> double {
-        // Since the graph is undirected, each undirected edge is represented by
-        // two directed edges, with the exception of self-loops, which are
-        // represented as one edge. Hence, the weight of each intra-cluster edge
-        // must be divided by 2, unless it's a self-loop.
-        if (u == v)
-          return weight;
-        // This assumes that the graph is undirected, and self-loops are counted
-        // as half of the weight.
-        if (cluster_id_i == cluster_ids[v])
-          return (weight - edge_weight_offset[k]) / 2;
-        return 0;
-      };
-      shifted_edge_weight[i] = graph.Graph()->get_vertex(i).out_neighbors().reduce(
-          intra_cluster_sum_map_f, add_m);
-    });
-    double objective = parlay::reduce(shifted_edge_weight);
-  
-    auto resolution_seq = parlay::delayed_seq<double>(n, [&](std::size_t i) {
-      auto cluster_weight = clustering[cluster_ids[i]].size(); // cluster_weight
-      const double node_weight = 1.0;
-      return node_weight * (cluster_weight - node_weight);
-    });
-    objective -= resolution[k] * parlay::reduce(resolution_seq) / 2;
-  
+    // Since the graph is undirected, each undirected edge is represented by two
+    // directed edges, with the exception of self-loops, which are represented
+    // as one edge. Hence, the weight of each intra-cluster edge is halved,
+    // unless it's a self-loop.
+    double objective = (sums.intra_cluster_pair_weight -
+      edge_weight_offset[k] * sums.intra_cluster_pair_count) / 2 + sums.self_loop_weight;
+    objective -= resolution[k] * sums.cluster_pair_count;
     clustering_stats->add_correlation_objective(objective);
   }
 
   return absl::OkStatus();
 }
 
+inline absl::Status ComputeCorrelationObjective(const GbbsGraph& graph, 
+  const InMemoryClusterer::Clustering& clustering, ClusteringStatistics* clustering_stats,
+  const parlay::sequence<gbbs::uintE>& cluster_ids, const ClusteringStatsConfig& clustering_stats_config) {
+  if (clustering_stats_config.correlation_resolutions().empty()) {
+    return absl::OkStatus();
+  }
+  return ComputeCorrelationObjective(graph, clustering, clustering_stats, cluster_ids, clustering_stats_config,
+    ComputeObjectiveSums(graph, clustering, cluster_ids));
+}
+
+// Weighted modularity for each resolution in the config: the intra-cluster
+// edge weight minus resolution * volume^2 / total weight summed over clusters,
+// where the volume of a cluster is its total weighted degree, all divided by
+// the total weight. `sums` is ComputeObjectiveSums(graph, clustering, cluster_ids).
 inline absl::Status ComputeModularityObjective(const GbbsGraph& graph, 
   const InMemoryClusterer::Clustering& clustering, ClusteringStatistics* clustering_stats,
   const parlay::sequence<gbbs::uintE>& cluster_ids,
-  const ClusteringStatsConfig& clustering_stats_config){
-  size_t n = graph.Graph()->n;
+  const ClusteringStatsConfig& clustering_stats_config, const ObjectiveSums& sums){
   const google::protobuf::RepeatedField<double>& resolution = clustering_stats_config.modularity_resolutions();
 
-  std::vector<double> modularities(resolution.size());
-  parlay::parallel_for(0, resolution.size(), [&](std::size_t k){
-    parlay::sequence<double> edge_weights(n, 0);  // Initialized with zeros
-    parlay::sequence<double> modularities_tmp(n, 0);
-
-    parlay::parallel_for(0, n, [&](std::size_t i) {
-      auto vtx = graph.Graph()->get_vertex(i);
-      double local_edge_weight = 0;
-      double local_modularity = 0;
-      auto map_out = [&](gbbs::uintE u, gbbs::uintE nbhr, float w) {
-          local_edge_weight++;
-          if (cluster_ids[i] == cluster_ids[nbhr]) {
-              local_modularity++;
-          }
-      };
-      vtx.out_neighbors().map(map_out, false);
-      edge_weights[i] = local_edge_weight;
-      modularities_tmp[i] = local_modularity;
-    });
-
-    // Accumulate the results using parallel reduction
-    const double total_edge_weight = parlay::reduce(edge_weights);
-    double modularity = parlay::reduce(modularities_tmp);
-
-    //modularity = modularity / 2; // avoid double counting
-
-    auto modularity_deltas = parlay::delayed_seq<double>(clustering.size(), [&](std::size_t i){
-      auto degrees = parlay::delayed_seq<double>(clustering[i].size(), [&](std::size_t j){
-        auto vtx_id = clustering[i][j];
-        auto vtx = graph.Graph()->get_vertex(vtx_id);
-        return vtx.out_degree();
-      });
-      double degree = parlay::reduce(degrees);
-      return (resolution[k] * degree * degree) / (total_edge_weight);
-    });
-    double modularity_delta = parlay::reduce(modularity_deltas);
-
-    modularity -= modularity_delta;
-
-    modularity = modularity / (total_edge_weight);
-    modularities[k] = modularity;
-  }); 
-
-  for (auto modularity: modularities){
+  for (size_t k = 0; k < resolution.size(); k++) {
+    double modularity = sums.intra_cluster_weight -
+      resolution[k] * sums.squared_volume_sum / sums.total_weight;
+    modularity = modularity / sums.total_weight;
     clustering_stats->add_modularity_objective(modularity);
   }
   return absl::OkStatus();
 }
 
+inline absl::Status ComputeModularityObjective(const GbbsGraph& graph, 
+  const InMemoryClusterer::Clustering& clustering, ClusteringStatistics* clustering_stats,
+  const parlay::sequence<gbbs::uintE>& cluster_ids,
+  const ClusteringStatsConfig& clustering_stats_config){
+  if (clustering_stats_config.modularity_resolutions().empty()) {
+    return absl::OkStatus();
+  }
+  return ComputeModularityObjective(graph, clustering, clustering_stats, cluster_ids, clustering_stats_config,
+    ComputeObjectiveSums(graph, clustering, cluster_ids));
+}
+
 }  // namespace research_graph::in_memory
 
 #endif  // RESEARCH_GRAPH_IN_MEMORY_CLUSTERING_STATS_COMMUNITIES_H_
\ No newline at end of file
@@ -5,7 +5,9 @@
 #include <chrono>
 #include <iomanip>
 #include <memory>
+#include <algorithm>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/flags/flag.h"
@@ -23,25 +25,61 @@
 #include "parcluster/api/in-memory-clusterer-base.h"
 #include "parcluster/api/status_macros.h"
 
-#include "benchmarks/TriangleCounting/ShunTangwongsan15/Triangle.h"
-
 namespace research_graph::in_memory {
 
 
+// Number and total weight of the directed intra-cluster edges of each cluster.
+struct IntraClusterEdges {
+  parlay::sequence<size_t> counts;
+  parlay::sequence<double> weights;
+};
+
+// Sums the intra-cluster edges of every cluster in one pass over the edges of
+// the clustered vertices: each vertex sums its own intra-cluster edges, and the sums of
+// each cluster are combined with a parallel reduction, without atomics.
+// labels[i] is the cluster id of vertex i, and vertices outside `clustering`
+// count for no cluster.
+inline IntraClusterEdges CountIntraClusterEdges(const GbbsGraph& graph,
+  const InMemoryClusterer::Clustering& clustering, const parlay::sequence<gbbs::uintE>& labels) {
+  using Sums = std::pair<size_t, double>;
+  auto add_sums = parlay::make_monoid([](const Sums& a, const Sums& b) {
+    return Sums{a.first + b.first, a.second + b.second};
+  }, Sums{0, 0});
+  auto is_clustered = ClusteredVertices(graph.Graph()->n, clustering);
+  auto cluster_sums = parlay::sequence<Sums>::from_function(clustering.size(), [&](size_t i) {
+    return parlay::reduce(parlay::delayed_seq<Sums>(clustering[i].size(), [&](size_t j) {
+      auto map_f = [&](gbbs::uintE u, gbbs::uintE v, float weight) -> Sums {
+        if (is_clustered[v] && labels[u] == labels[v]) return Sums{1, weight};
+        return Sums{0, 0};
+      };
+      return graph.Graph()->get_vertex(clustering[i][j]).out_neighbors().reduce(map_f, add_sums);
+    }), add_sums);
+  });
+
+  IntraClusterEdges edges;
+  edges.counts = parlay::map(cluster_sums, [](const Sums& sums) { return sums.first; });
+  edges.weights = parlay::map(cluster_sums, [](const Sums& sums) { return sums.second; });
+  return edges;
+}
+
 // Compute the edge density of each cluster.
 // Edge density is the number of edges divided by the number of possible edges.
+// The weighted edge density divides the total weight of the edges instead.
 // It assumes that all node ids in clustering and cluster_ids are in `graph`.
 inline absl::Status ComputeEdgeDensity(const GbbsGraph& graph, 
   const InMemoryClusterer::Clustering& clustering, ClusteringStatistics* clustering_stats,
   const parlay::sequence<gbbs::uintE>& cluster_ids, const ClusteringStatsConfig& clustering_stats_config) {
   const bool compute_edge_density = clustering_stats_config.compute_edge_density();
+  const bool compute_weighted_edge_density = clustering_stats_config.compute_weighted_edge_density();
   const bool include_zero_degree_nodes = clustering_stats_config.include_zero_degree_nodes();
-  if (!compute_edge_density) {
+  if (!compute_edge_density && !compute_weighted_edge_density) {
     return absl::OkStatus();
   }
 
   std::size_t n = graph.Graph()->n;
+  auto intra_cluster_edges = CountIntraClusterEdges(graph, clustering, cluster_ids);
   auto result = parlay::sequence<double>(clustering.size());
+  auto weighted_result = parlay::sequence<double>(clustering.size());
 
   parlay::parallel_for(0, clustering.size(), [&] (size_t i) {
     const double cluster_size = clustering[i].size();
@@ -52,16 +90,11 @@ inline absl::Status ComputeEdgeDensity(const GbbsGraph& graph,
       }else{
         result[i] = 1;
       }
+      weighted_result[i] = result[i];
     }else{
       double m_total = cluster_size * (cluster_size - 1);
-      // std::cout <<  "m_total" << " " <<  m_total << std::endl;
-      if(clustering.size()==1 && cluster_size == n){ // All nodes are in a cluster.
-        result[i] = (static_cast<double>(graph.Graph()->m)) / m_total;
-      }else{
-        size_t m_subgraph = get_subgraph_num_edges(graph, clustering[i], cluster_ids);
-        // std::cout << "m_subgraph" << " " << m_subgraph << std::endl;
-        result[i] = (static_cast<double>(m_subgraph)) / m_total;
-      }
+      result[i] = (static_cast<double>(intra_cluster_edges.counts[i])) / m_total;
+      weighted_result[i] = intra_cluster_edges.weights[i] / m_total;
     }
   });
 
@@ -69,31 +102,115 @@ inline absl::Status ComputeEdgeDensity(const GbbsGraph& graph,
   // Recompute `n` for weighted_result_func to ignore singleton zero-degree nodes.
   if (!include_zero_degree_nodes){
     result = parlay::filter(result, [&](double i){return i != -1;});
+    weighted_result = parlay::filter(weighted_result, [&](double i){return i != -1;});
     auto nodes_flags = parlay::delayed_seq<size_t>(n, [&](size_t i){
       return graph.Degree(i) == 0 ? 0 : 1;
     });
     n = parlay::reduce(nodes_flags);
   }
 
-  auto result_func = [&](std::size_t i) {
-    return result[i];
-  };
-  auto weighted_result_func = [&](std::size_t i) {
-    // Divide result.size() instead of n because some singleton 
-    // zero degree nodes might be filtered out above.
-    return result[i] * (clustering[i].size() * 1.0 / n);
-  };
-  double weighted_mean = 0;
-  for (int i=0;i<result.size();++i){
-    weighted_mean += weighted_result_func(i);
-    // std::cout << result[i] << " " << weighted_result_func(i) << std::endl;
+  if (compute_edge_density) {
+    auto result_func = [&](std::size_t i) {
+      return result[i];
+    };
+    auto weighted_result_func = [&](std::size_t i) {
+      // Divide result.size() instead of n because some singleton 
+      // zero degree nodes might be filtered out above.
+      return result[i] * (clustering[i].size() * 1.0 / n);
+    };
+    double weighted_mean = 0;
+    for (int i=0;i<result.size();++i){
+      weighted_mean += weighted_result_func(i);
+    }
+    set_distribution_stats(result.size(), result_func, clustering_stats->mutable_edge_density());
+    clustering_stats->set_weighted_edge_density_mean(weighted_mean);
+  }
+
+  if (compute_weighted_edge_density) {
+    auto weighted_density_func = [&](std::size_t i) {
+      return weighted_result[i];
+    };
+    set_distribution_stats(weighted_result.size(), weighted_density_func, clustering_stats->mutable_weighted_edge_density());
   }
-  set_distribution_stats(result.size(), result_func, clustering_stats->mutable_edge_density());
-  clustering_stats->set_weighted_edge_density_mean(weighted_mean);
 
   return absl::OkStatus();
 }
 
+// Number of triangles and wedges in the subgraph induced by each cluster.
+struct ClusterTriangleCounts {
+  parlay::sequence<size_t> triangles;
+  parlay::sequence<size_t> wedges;
+};
+
+// Counts the triangles of all clusters of `partitioned_graph` at once. Each
+// intra-cluster edge is directed from its endpoint of lower (degree, id) rank
+// to the higher one, and every triangle is found exactly once, from its lowest
+// ranked vertex, by intersecting the sorted out-neighbors of the endpoints of
+// its edges. As clusters are contiguous in the CSR, the count of each cluster
+// is a sum over its block of vertices.
+inline ClusterTriangleCounts CountClusterTriangles(const ClusterPartitionedGraph& partitioned_graph) {
+  using uintE = gbbs::uintE;
+  const auto& vertex_offsets = partitioned_graph.vertex_offsets;
+  const auto& edge_offsets = partitioned_graph.edge_offsets;
+  size_t num_clusters = partitioned_graph.NumClusters();
+  size_t num_vertices = vertex_offsets[num_clusters];
+  auto degree = [&](size_t x) { return edge_offsets[x + 1] - edge_offsets[x]; };
+  auto ranks_below = [&](size_t x, size_t y) {
+    return degree(x) < degree(y) || (degree(x) == degree(y) && x < y);
+  };
+
+  // Directed edges to higher ranked neighbors, by CSR vertex
+  auto out_offsets = parlay::sequence<size_t>(num_vertices + 1, 0);
+  parlay::parallel_for(0, num_clusters, [&] (size_t i) {
+    parlay::parallel_for(vertex_offsets[i], vertex_offsets[i + 1], [&] (size_t x) {
+      size_t count = 0;
+      for (size_t e = edge_offsets[x]; e < edge_offsets[x + 1]; e++) {
+        if (ranks_below(x, vertex_offsets[i] + std::get<0>(partitioned_graph.edges[e]))) count++;
+      }
+      out_offsets[x] = count;
+    });
+  });
+  size_t num_out_edges = parlay::scan_inplace(out_offsets);
+  auto out_edges = parlay::sequence<uintE>::uninitialized(num_out_edges);
+  parlay::parallel_for(0, num_clusters, [&] (size_t i) {
+    parlay::parallel_for(vertex_offsets[i], vertex_offsets[i + 1], [&] (size_t x) {
+      size_t k = out_offsets[x];
+      for (size_t e = edge_offsets[x]; e < edge_offsets[x + 1]; e++) {
+        size_t y = vertex_offsets[i] + std::get<0>(partitioned_graph.edges[e]);
+        if (ranks_below(x, y)) out_edges[k++] = y;
+      }
+      std::sort(out_edges.begin() + out_offsets[x], out_edges.begin() + k);
+    });
+  });
+
+  auto vertex_triangles = parlay::sequence<size_t>::from_function(num_vertices, [&] (size_t x) {
+    size_t count = 0;
+    for (size_t k = out_offsets[x]; k < out_offsets[x + 1]; k++) {
+      size_t y = out_edges[k];
+      size_t a = out_offsets[x], b = out_offsets[y];
+      while (a < out_offsets[x + 1] && b < out_offsets[y + 1]) {
+        if (out_edges[a] < out_edges[b]) a++;
+        else if (out_edges[a] > out_edges[b]) b++;
+        else { count++; a++; b++; }
+      }
+    }
+    return count;
+  });
+
+  ClusterTriangleCounts counts;
+  counts.triangles = parlay::sequence<size_t>::from_function(num_clusters, [&] (size_t i) {
+    return parlay::reduce(vertex_triangles.cut(vertex_offsets[i], vertex_offsets[i + 1]));
+  });
+  counts.wedges = parlay::sequence<size_t>::from_function(num_clusters, [&] (size_t i) {
+    return parlay::reduce(parlay::delayed_seq<size_t>(
+      vertex_offsets[i + 1] - vertex_offsets[i], [&] (size_t j) {
+        size_t d = degree(vertex_offsets[i] + j);
+        return d * (d - 1) / 2;
+      }));
+  });
+  return counts;
+}
+
 /**
  * Compute the triangle density of each cluster. It is also called clustering coefficient.
  *
@@ -102,10 +219,15 @@ inline absl::Status ComputeEdgeDensity(const GbbsGraph& graph,
  * Each unique wedge is counted once. So each unique triangle correspondes to three unique wedges.
  *
  * If there are no wedges, the density is 0. However, if there's a single node, the density is 1.
+ *
+ * The clusters are read from `partitioned_graph`, which is
+ * PartitionByCluster(graph, clustering, cluster_ids), and the triangles of all
+ * clusters are counted in a single pass over it, on the unweighted graph.
  */
 inline absl::Status ComputeTriangleDensity(const GbbsGraph& graph, 
   const InMemoryClusterer::Clustering& clustering, ClusteringStatistics* clustering_stats,
-  const parlay::sequence<gbbs::uintE>& cluster_ids, const ClusteringStatsConfig& clustering_stats_config) {
+  const parlay::sequence<gbbs::uintE>& cluster_ids, const ClusteringStatsConfig& clustering_stats_config,
+  const ClusterPartitionedGraph& partitioned_graph) {
   const bool compute_triangle_density = clustering_stats_config.compute_triangle_density();
   if (!compute_triangle_density) {
     return absl::OkStatus();
@@ -114,9 +236,8 @@ inline absl::Status ComputeTriangleDensity(const GbbsGraph& graph,
 
   std::size_t n = graph.Graph()->n;
   auto result = parlay::sequence<double>(clustering.size());
-  auto f = [&] (gbbs::uintE u, gbbs::uintE v, gbbs::uintE w) { };
+  auto counts = CountClusterTriangles(partitioned_graph);
 
-  //even if clustering.size()==1, we need to get the subgraph because could not match 'symmetric_graph' against 'symmetric_ptr_graph'
     parlay::parallel_for(0, clustering.size(), [&] (size_t i) {
       if (clustering[i].size() == 1){
         const auto singleton_node_id = clustering[i][0];
@@ -126,21 +247,11 @@ inline absl::Status ComputeTriangleDensity(const GbbsGraph& graph,
           result[i] = 1;
         }
       } else {
-        auto G = get_subgraph<gbbs::empty>(graph, clustering[i], cluster_ids); //have to use unweighted graph, otherwise result is wrong
-        size_t num_wedges = get_num_wedges(&G);
+        size_t num_wedges = counts.wedges[i];
         if(num_wedges < 3){
           result[i] = 0;
         }else{
-          // std::cout << "start \n";
-          // std::cout << "clustering size " << clustering[i].size() << std::endl;
-          // std::cout << clustering[i][0] << std::endl;
-          // std::cout << "subgrpah num nodes " << G.n << std::endl;
-          // std::cout << "subgraph num edges " << G.num_edges() << std::endl;
-
-          size_t num_tri = 0;
-          if (G.num_edges() >= 3 && G.num_vertices() >= 3){
-            num_tri =  gbbs::Triangle_degree_ordering(G, f);
-          }
+          size_t num_tri = counts.triangles[i];
           result[i] = 3 * (static_cast<double>(num_tri)) / (static_cast<double>(num_wedges));
         }
       }
@@ -175,6 +286,16 @@ inline absl::Status ComputeTriangleDensity(const GbbsGraph& graph,
   return absl::OkStatus();
 }
 
+inline absl::Status ComputeTriangleDensity(const GbbsGraph& graph, 
+  const InMemoryClusterer::Clustering& clustering, ClusteringStatistics* clustering_stats,
+  const parlay::sequence<gbbs::uintE>& cluster_ids, const ClusteringStatsConfig& clustering_stats_config) {
+  if (!clustering_stats_config.compute_triangle_density()) {
+    return absl::OkStatus();
+  }
+  return ComputeTriangleDensity(graph, clustering, clustering_stats, cluster_ids, clustering_stats_config,
+    PartitionByCluster(graph, clustering, cluster_ids));
+}
+
 
 }  // namespace research_graph::in_memory
 
@@ -44,7 +44,7 @@ inline size_t num_cc(Seq& labels) {
 
 inline void ComputeComponentHelper(const GbbsGraph& graph, 
   const InMemoryClusterer::Clustering& clustering, ClusteringStatistics* clustering_stats,
-  const parlay::sequence<gbbs::uintE>& cluster_ids, std::vector<int>& component_vec) {
+  const ClusterPartitionedGraph& partitioned_graph, std::vector<int>& component_vec) {
 
   if(clustering.size()==1){ // a single cluster, no need to obtain subgraph of each cluster
     auto cc_labels = gbbs::simple_union_find::SimpleUnionAsync(*graph.Graph());
@@ -52,7 +52,7 @@ inline void ComputeComponentHelper(const GbbsGraph& graph,
     component_vec[0] = cc;
   }else{
     parlay::parallel_for(0, clustering.size(), [&] (size_t i) {
-        auto G = get_subgraph(graph, clustering[i], cluster_ids);
+        auto G = partitioned_graph.Subgraph(i);
         auto cc_labels = gbbs::simple_union_find::SimpleUnionAsync(G);
         std::size_t cc = num_cc(cc_labels);
         component_vec[i] = cc;
@@ -91,9 +91,125 @@ auto BellmanFordNoPrint(Graph& G, gbbs::uintE start) {
   return SP;
 }
 
+// Updates BFS distances for gbbs::edgeMap: a vertex is reached at `level` the
+// first time any of its neighbors is in the frontier.
+struct BFSDistanceF {
+  gbbs::uintE* distances;
+  gbbs::uintE level;
+
+  template <class W>
+  bool update(const gbbs::uintE& s, const gbbs::uintE& d, const W& w) {
+    if (distances[d] == UINT_E_MAX) {
+      distances[d] = level;
+      return true;
+    }
+    return false;
+  }
+  template <class W>
+  bool updateAtomic(const gbbs::uintE& s, const gbbs::uintE& d, const W& w) {
+    return gbbs::atomic_compare_and_swap(&distances[d], UINT_E_MAX, level);
+  }
+  bool cond(const gbbs::uintE& d) { return distances[d] == UINT_E_MAX; }
+};
+
+// Returns the number of hops from `start` to every vertex of `G`.
+template <class Graph>
+auto BFSDistances(Graph& G, gbbs::uintE start) {
+  size_t n = G.n;
+  auto distances = parlay::sequence<gbbs::uintE>(n, UINT_E_MAX);
+  distances[start] = 0;
+  gbbs::vertexSubset Frontier(n, start);
+  gbbs::uintE level = 0;
+  while (!Frontier.isEmpty()) {
+    level++;
+    auto output = gbbs::edgeMap(G, Frontier, BFSDistanceF{distances.begin(), level},
+                                G.m / 10, gbbs::sparse_blocked | gbbs::dense_forward);
+    Frontier = std::move(output);
+  }
+  return distances;
+}
+
+// Returns the shortest path distances from `start` in the connected graph `G`:
+// hop counts if all its edge weights are `unit_weights`, weighted distances
+// from Bellman-Ford otherwise.
+template <class Graph>
+parlay::sequence<double> ShortestPathDistances(Graph& G, gbbs::uintE start, bool unit_weights) {
+  if (unit_weights) {
+    auto distances = BFSDistances(G, start);
+    return parlay::map(distances, [](gbbs::uintE d) { return static_cast<double>(d); });
+  }
+  auto SP = BellmanFordNoPrint(G, start);
+  return parlay::map(SP, [](const auto& d) { return static_cast<double>(d); });
+}
+
+// Returns true if every edge of `G` has weight 1.
+template <class Graph>
+bool HasUnitWeights(Graph& G) {
+  return parlay::reduce(parlay::delayed_seq<size_t>(G.n, [&](size_t i) {
+    return G.get_vertex(i).out_neighbors().count(
+        [](gbbs::uintE u, gbbs::uintE v, const auto& w) { return w != 1; });
+  })) == 0;
+}
+
+template <class Graph>
+gbbs::uintE HighestDegreeVertex(Graph& G) {
+  auto degrees = parlay::delayed_seq<size_t>(G.n, [&](size_t i) {
+    return G.get_vertex(i).out_degree();
+  });
+  return parlay::max_element(degrees) - degrees.begin();
+}
+
+// Returns the vertex with the largest of `distances` from some start vertex,
+// and that distance.
+inline std::pair<gbbs::uintE, double> Farthest(const parlay::sequence<double>& distances) {
+  auto it = parlay::max_element(distances);
+  return {static_cast<gbbs::uintE>(it - distances.begin()), *it};
+}
+
+// Returns the double-sweep lower bound on the diameter of the connected graph
+// `G`: the eccentricity of a vertex farthest from a highest degree vertex.
+// This is at least half of the diameter, and usually equal to it.
+template <class Graph>
+double DoubleSweepDiameter(Graph& G) {
+  if (G.n <= 1) return 0;
+  const bool unit_weights = HasUnitWeights(G);
+  gbbs::uintE start = HighestDegreeVertex(G);
+  auto [a, ecc_start] = Farthest(ShortestPathDistances(G, start, unit_weights));
+  return std::max(ecc_start, Farthest(ShortestPathDistances(G, a, unit_weights)).second);
+}
+
+// Returns the exact diameter of the connected graph `G` with iFUB: after one
+// traversal from a highest degree vertex u, the eccentricities of vertices are
+// computed in decreasing distance from u. Any pair of the remaining vertices,
+// which are within distance D of u, is within distance 2D, so the search stops
+// once the largest eccentricity found reaches 2D. This usually takes a handful
+// of traversals instead of one per vertex.
+template <class Graph>
+double IFUBDiameter(Graph& G) {
+  size_t n = G.n;
+  if (n <= 1) return 0;
+  const bool unit_weights = HasUnitWeights(G);
+  gbbs::uintE start = HighestDegreeVertex(G);
+  auto distances = ShortestPathDistances(G, start, unit_weights);
+  double lower_bound = *parlay::max_element(distances);
+
+  // Vertices by decreasing distance from `start`.
+  auto order = parlay::sort(parlay::iota<gbbs::uintE>(n), [&](gbbs::uintE a, gbbs::uintE b) {
+    return distances[a] > distances[b];
+  });
+  for (size_t i = 0; i + 1 < n; i++) {
+    if (lower_bound >= 2 * distances[order[i]]) break;
+    lower_bound = std::max(lower_bound,
+        Farthest(ShortestPathDistances(G, order[i], unit_weights)).second);
+  }
+  return lower_bound;
+}
+
+// `partitioned_graph` is PartitionByCluster(graph, clustering, cluster_ids).
 inline absl::Status ComputeDiameter(const GbbsGraph& graph, 
   const InMemoryClusterer::Clustering& clustering, ClusteringStatistics* clustering_stats,
-  const parlay::sequence<gbbs::uintE>& cluster_ids, const ClusteringStatsConfig& clustering_stats_config) {
+  const parlay::sequence<gbbs::uintE>& cluster_ids, const ClusteringStatsConfig& clustering_stats_config,
+  const ClusterPartitionedGraph& partitioned_graph) {
   
   const bool compute_num_component = clustering_stats_config.compute_num_component();
   const bool compute_diameter = clustering_stats_config.compute_diameter();
@@ -103,7 +219,7 @@ inline absl::Status ComputeDiameter(const GbbsGraph& graph,
   }
 
   std::vector<int> component_vec = std::vector<int>(clustering.size());
-  ComputeComponentHelper(graph, clustering, clustering_stats, cluster_ids, component_vec);
+  ComputeComponentHelper(graph, clustering, clustering_stats, partitioned_graph, component_vec);
 
   if (compute_num_component) {
     auto component_func = [&](std::size_t i) {
@@ -115,18 +231,13 @@ inline absl::Status ComputeDiameter(const GbbsGraph& graph,
   if (!compute_diameter) {
     return absl::OkStatus();
   }
+  const bool approximate_diameter = clustering_stats_config.approximate_diameter();
   parlay::sequence<double> diameter_vec = parlay::sequence<double>::uninitialized(clustering.size());
 
   parlay::parallel_for(0, clustering.size(), [&] (size_t i) {
     if(component_vec[i]==1){ // only compute diameter for single connected component cluster
-      auto G = get_subgraph(graph, clustering[i], cluster_ids); 
-      auto distances = parlay::sequence<float>::uninitialized(clustering[i].size());
-      parlay::parallel_for(0, clustering[i].size(), [&] (size_t j) {
-          auto SP = BellmanFordNoPrint(G, j); //use j because the subgraph is re-indexed
-          distances[j] = *(parlay::max_element(SP));            
-      });
-      auto diameter = *(parlay::max_element(distances));
-      diameter_vec[i] = diameter;
+      auto G = partitioned_graph.Subgraph(i);
+      diameter_vec[i] = approximate_diameter ? DoubleSweepDiameter(G) : IFUBDiameter(G);
     }
   });
 
@@ -143,6 +254,16 @@ inline absl::Status ComputeDiameter(const GbbsGraph& graph,
   return absl::OkStatus();
 }
 
+inline absl::Status ComputeDiameter(const GbbsGraph& graph, 
+  const InMemoryClusterer::Clustering& clustering, ClusteringStatistics* clustering_stats,
+  const parlay::sequence<gbbs::uintE>& cluster_ids, const ClusteringStatsConfig& clustering_stats_config) {
+  if ((!clustering_stats_config.compute_num_component()) && (!clustering_stats_config.compute_diameter())) {
+    return absl::OkStatus();
+  }
+  return ComputeDiameter(graph, clustering, clustering_stats, cluster_ids, clustering_stats_config,
+    PartitionByCluster(graph, clustering, cluster_ids));
+}
+
 }  // namespace research_graph::in_memory
 
 #endif  // RESEARCH_GRAPH_IN_MEMORY_CLUSTERING_STATS_DIAMETER_H_
\ No newline at end of file
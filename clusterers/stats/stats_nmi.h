@@ -20,109 +20,24 @@
 #include "parcluster/api/gbbs-graph.h"
 #include "parcluster/api/in-memory-clusterer-base.h"
 #include "parcluster/api/status_macros.h"
-#include "clusterers/stats/stats_ari.h"
-
-#include "parlay/hash_table.h"
+#include "clusterers/stats/stats_contingency.h"
 
 namespace research_graph::in_memory {
 
 
 // Compute NMI using cluster entropy, ground truth entropy, and conditional entropy
 inline absl::Status ComputeNMI(
-  const size_t n,
-  const InMemoryClusterer::Clustering& clustering, ClusteringStatistics* clustering_stats,
-  const InMemoryClusterer::Clustering& ground_truth,
+  const size_t n, const ContingencyTable& table,
+  ClusteringStatistics* clustering_stats,
   const ClusteringStatsConfig& clustering_stats_config){
     const bool compute_nmi = clustering_stats_config.compute_nmi();
   if (!compute_nmi) {
     return absl::OkStatus();
   }
 
-
-  size_t num_cluster_1 = clustering.size();
-  size_t num_cluster_2 = ground_truth.size();
-
-  // Ground truth entropy
-  std::vector<long double> community_entropys(num_cluster_2);
-  parlay::parallel_for(0, num_cluster_2, [&](size_t i){
-    long double proportion = ((long double)ground_truth[i].size()) / n;
-    if (proportion > 0){
-      community_entropys[i] = -proportion * (log2l(ground_truth[i].size()) - log2l(n)); 
-    }
-    else{
-      community_entropys[i] = 0; 
-    }
-  });
-  long double community_entropy = parlay::reduce(community_entropys);
-
-  // Cluster entropy
-  std::vector<long double> cluster_entropys(num_cluster_1);
-  parlay::parallel_for(0, num_cluster_1, [&](size_t i){
-    long double proportion = ((long double)clustering[i].size()) / n;
-    if (proportion > 0){
-      cluster_entropys[i] = -proportion * (log2l(clustering[i].size()) - log2l(n)); 
-    }
-    else{
-      cluster_entropys[i] = 0; 
-    }
-  });
-  long double cluster_entropy = parlay::reduce(cluster_entropys);
-
-
-  // Calculate conditional entropy
-  using tableT = parlay::hashtable<hash_numeric_unsigned <gbbs::uintE> >;
-  auto empty_val = hash_numeric_unsigned <gbbs::uintE>().empty();
-
-  std::vector<tableT*> tables1(num_cluster_1);
-  std::vector<tableT*> tables2(num_cluster_2);
-  parlay::parallel_for(0, num_cluster_1, [&](size_t i){
-    tables1[i] = new tableT(clustering[i].size(), hash_numeric_unsigned<gbbs::uintE>{});
-    parlay::parallel_for(0, clustering[i].size(), [&](size_t j){
-    tables1[i]->insert(clustering[i][j]);
-    });
-  });
-  parlay::parallel_for(0, num_cluster_2, [&](size_t i){
-    tables2[i] = new tableT(ground_truth[i].size(), hash_numeric_unsigned<gbbs::uintE>{});
-    parlay::parallel_for(0, ground_truth[i].size(), [&](size_t j){
-    tables2[i]->insert(ground_truth[i][j]);
-    });
-  });
-
-  std::vector<long double> conditional_entropys(num_cluster_1);
-  parlay::parallel_for(0, num_cluster_1, [&](size_t i){
-    std::vector<long double> match(num_cluster_2);
-    size_t cluster_size = clustering[i].size();
-    parlay::parallel_for(0, num_cluster_2, [&](size_t j){
-        size_t val = 0;
-
-        if(clustering[i].size() < ground_truth[j].size()){
-        auto flags = parlay::delayed_seq<std::size_t>(clustering[i].size(), [&](size_t k){
-            return tables2[j]->find(clustering[i][k]) == empty_val? 0 : 1 ; 
-        });
-        val = parlay::reduce(flags);
-        }else{
-        auto flags = parlay::delayed_seq<std::size_t>(ground_truth[j].size(), [&](size_t k){
-            return tables1[i]->find(ground_truth[j][k]) == empty_val? 0 : 1 ;
-        });
-        val = parlay::reduce(flags);
-        }
-
-        long double proportion = ((long double)val) / cluster_size;
-        if (proportion > 0){
-            match[j] = proportion * (log2l(val) - log2l(cluster_size));
-        }
-        else{
-            match[j] = 0;
-        }
-        
-        
-    });
-    long double entropy = parlay::reduce(match);
-    long double proportion = ((long double) cluster_size) / n;
-    conditional_entropys[i] = - proportion * entropy;
-  });
-
-  long double conditional_entropy = parlay::reduce(conditional_entropys);
+  long double community_entropy = Entropy(table.community_sizes, n);
+  long double cluster_entropy = Entropy(table.cluster_sizes, n);
+  long double conditional_entropy = ConditionalEntropy(table, table.cluster_sizes, n);
 
   // NMI calculation from calculated entropys
   double nmi_value = 2 * (community_entropy - conditional_entropy) / (community_entropy + cluster_entropy);
@@ -130,13 +45,76 @@ inline absl::Status ComputeNMI(
 
   clustering_stats->set_nmi(nmi_value);
 
-  parlay::parallel_for(0, num_cluster_1, [&](size_t i){
-    delete tables1[i];
-  });
+  return absl::OkStatus();
+}
+
+inline absl::Status ComputeNMI(
+  const size_t n,
+  const InMemoryClusterer::Clustering& clustering, ClusteringStatistics* clustering_stats,
+  const InMemoryClusterer::Clustering& ground_truth,
+  const ClusteringStatsConfig& clustering_stats_config){
+  if (!clustering_stats_config.compute_nmi()) {
+    return absl::OkStatus();
+  }
+  return ComputeNMI(n, ComputeContingencyTable(clustering, ground_truth),
+                    clustering_stats, clustering_stats_config);
+}
+
+// Compute AMI, the mutual information adjusted for chance and normalized by
+// the mean of the cluster and ground truth entropies
+inline absl::Status ComputeAMI(
+  const size_t n, const ContingencyTable& table,
+  ClusteringStatistics* clustering_stats,
+  const ClusteringStatsConfig& clustering_stats_config){
+  if (!clustering_stats_config.compute_ami()) {
+    return absl::OkStatus();
+  }
+
+  long double community_entropy = Entropy(table.community_sizes, n);
+  long double cluster_entropy = Entropy(table.cluster_sizes, n);
+  long double mutual_information =
+      community_entropy - ConditionalEntropy(table, table.cluster_sizes, n);
+  long double expected_mutual_information =
+      ExpectedMutualInformation(table.cluster_sizes, table.community_sizes, n);
+
+  long double denominator =
+      (community_entropy + cluster_entropy) / 2 - expected_mutual_information;
+  // Both partitions are trivial if their entropies are zero
+  double ami_value = std::fabs(denominator) < 1e-15
+      ? 1.0
+      : (mutual_information - expected_mutual_information) / denominator;
+
+  clustering_stats->set_ami(ami_value);
+
+  return absl::OkStatus();
+}
+
+// Compute homogeneity (each cluster holds one community), completeness (each
+// community is in one cluster) and their harmonic mean, the V-measure
+inline absl::Status ComputeVMeasure(
+  const size_t n, const ContingencyTable& table,
+  ClusteringStatistics* clustering_stats,
+  const ClusteringStatsConfig& clustering_stats_config){
+  if (!clustering_stats_config.compute_v_measure()) {
+    return absl::OkStatus();
+  }
 
-  parlay::parallel_for(0, num_cluster_2, [&](size_t i){
-    delete tables2[i];
-  });
+  long double community_entropy = Entropy(table.community_sizes, n);
+  long double cluster_entropy = Entropy(table.cluster_sizes, n);
+  long double homogeneity = community_entropy > 0
+      ? 1 - ConditionalEntropy(table, table.cluster_sizes, n) / community_entropy
+      : 1;
+  long double completeness = cluster_entropy > 0
+      ? 1 - ConditionalEntropy(table, table.community_sizes, n,
+                               /*given_ground_truth=*/true) / cluster_entropy
+      : 1;
+  double v_measure = homogeneity + completeness > 0
+      ? 2 * homogeneity * completeness / (homogeneity + completeness)
+      : 0;
+
+  clustering_stats->set_homogeneity(homogeneity);
+  clustering_stats->set_completeness(completeness);
+  clustering_stats->set_v_measure(v_measure);
 
   return absl::OkStatus();
 }
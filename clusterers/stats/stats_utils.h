@@ -6,6 +6,7 @@
 #include <iomanip>
 #include <memory>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include "absl/flags/flag.h"
@@ -49,85 +50,138 @@ inline void set_distribution_stats(std::size_t size, const T& data, Distribution
   distribution_stats->set_maximum(max);
 }
 
-// return a subgraph that has the vertices in V
-// if keep_ids=false, the ids in subgraph do not neccessarily corresponds to the original graph's node id
-// the number of nodes in the new subgraph is V.size()
-// labels[i] is the cluster id of vertex i
-// Only works for NON-OVERLAPPING clusteters.
-template <class Wgh=float>
-inline gbbs::symmetric_graph<gbbs::symmetric_vertex, Wgh> get_subgraph(const GbbsGraph& graph_, const std::vector<InMemoryClusterer::NodeId>& V, const parlay::sequence<gbbs::uintE>& labels, bool keep_ids = false){
-    // using Wgh = float;
-    using uintE = gbbs::uintE;
-    std::size_t n = V.size();
-    auto offsets = parlay::sequence<size_t>::from_function(
-      n, [&](size_t i) { return graph_.Graph()->get_vertex(V[i]).out_degree(); }); //double check, is numbers in V corresponding to the graph nodes?
-    auto new_m = parlay::scan_inclusive_inplace(offsets);
-    auto edges = parlay::sequence<std::tuple<uintE, uintE, Wgh>>::uninitialized(new_m);
-    auto flags = parlay::sequence<bool>(new_m, false); // flag[i] = true if the edge should be in the subgraph
-
-    auto map =  parlay::sequence<InMemoryClusterer::NodeId>::uninitialized(graph_.Graph()->n); // map from original graph id to new id in subgraph
-    if(keep_ids){
-    parlay::parallel_for(0, n, [&] (size_t i) {
-        map[V[i]] = V[i];
-    });
-    }else{
-    parlay::parallel_for(0, n, [&] (size_t i) {
-        map[V[i]] = i;
-    });
-    }
-
-
-    // copy edges in the subgraph to edges, and mark true in flags
-    parlay::parallel_for(0, n, [&] (size_t i) {
-        uintE vert = V[i];
-        std::size_t offset = i==0 ? 0 : offsets[i-1];
-        auto map_f = [&] (const auto& u, const auto& v, const auto& wgh, const auto& j) {
-            if(labels[u]==labels[v]){
-                flags[offset+j] = true;
-                if constexpr(std::is_same_v<Wgh, gbbs::empty>) {
-                  edges[offset+j] = std::tuple<uintE, uintE, gbbs::empty>(map[u],map[v], gbbs::empty());
-                } else {
-                  edges[offset+j] = std::tuple<uintE, uintE, Wgh>(map[u],map[v],wgh);
-                }
-                
-            }
-        };
-        graph_.Graph()->get_vertex(vert).out_neighbors().map_with_index(map_f);
-    });
+// For each vertex, the indices of the clusters containing it in ascending
+// order. Clusters may overlap.
+struct ClusterIndex {
+  // The clusters of vertex v are cluster_ids[offsets[v], offsets[v + 1]).
+  parlay::sequence<std::size_t> offsets;
+  parlay::sequence<gbbs::uintE> cluster_ids;
 
-    auto subgraph_edges = parlay::pack(edges, flags);
+  parlay::slice<const gbbs::uintE*, const gbbs::uintE*> Clusters(gbbs::uintE v) const {
+    if (v + 1 >= offsets.size()) return parlay::make_slice(cluster_ids.end(), cluster_ids.end());
+    return parlay::make_slice(cluster_ids.begin() + offsets[v], cluster_ids.begin() + offsets[v + 1]);
+  }
+};
+
+// Builds the cluster index of `clustering` with a stable integer sort of its
+// (vertex, cluster) memberships.
+inline ClusterIndex ClustersByVertex(const InMemoryClusterer::Clustering& clustering) {
+  auto cluster_offsets = parlay::sequence<std::size_t>::from_function(
+    clustering.size(), [&](std::size_t i){ return clustering[i].size(); });
+  std::size_t num_memberships = parlay::scan_inplace(cluster_offsets);
+  auto memberships = parlay::sequence<std::pair<gbbs::uintE, gbbs::uintE>>::uninitialized(num_memberships);
+  parlay::parallel_for(0, clustering.size(), [&](std::size_t i){
+    parlay::parallel_for(0, clustering[i].size(), [&](std::size_t k){
+      memberships[cluster_offsets[i] + k] = std::make_pair(clustering[i][k], static_cast<gbbs::uintE>(i));
+    });
+  });
+  auto vertices = parlay::delayed_map(memberships, [](const auto& membership){ return membership.first; });
+  std::size_t num_vertices = 1 + parlay::reduce(vertices, parlay::maxm<gbbs::uintE>());
+
+  ClusterIndex index;
+  index.offsets = parlay::histogram_by_index(vertices, num_vertices + 1);
+  parlay::scan_inplace(index.offsets);
+  auto sorted_memberships = parlay::stable_integer_sort(
+    parlay::make_slice(memberships), [](const auto& membership){ return membership.first; });
+  index.cluster_ids = parlay::map(sorted_memberships, [](const auto& membership){ return membership.second; });
+  return index;
+}
 
-    if(keep_ids){
-        return gbbs::sym_graph_from_edges(subgraph_edges, graph_.Graph()->n);
-    }else{
-        return gbbs::sym_graph_from_edges(subgraph_edges, n);
-    }
+// The subgraphs induced by the clusters of a NON-OVERLAPPING clustering, stored
+// as one CSR in which each cluster is a contiguous block. Vertex j of cluster i
+// (clustering[i][j]) is vertex vertex_offsets[i] + j of the CSR, and its edges
+// are the ones to the other vertices of cluster i, given by their index in the
+// cluster. Built in O(n + m) work, so that every per-cluster statistic can
+// share it instead of extracting each cluster from the whole graph.
+struct ClusterPartitionedGraph {
+  // Cluster i is CSR vertices [vertex_offsets[i], vertex_offsets[i + 1]).
+  parlay::sequence<size_t> vertex_offsets;
+  // The edges of CSR vertex x are edges[edge_offsets[x], edge_offsets[x + 1]).
+  parlay::sequence<size_t> edge_offsets;
+  parlay::sequence<std::tuple<gbbs::uintE, float>> edges;
+
+  size_t NumClusters() const { return vertex_offsets.size() - 1; }
+
+  // Number of directed intra-cluster edges of cluster i.
+  size_t NumEdges(size_t i) const {
+    return edge_offsets[vertex_offsets[i + 1]] - edge_offsets[vertex_offsets[i]];
+  }
 
+  // Returns the subgraph induced by cluster i, in which vertex j is
+  // clustering[i][j].
+  template <class Wgh=float>
+  gbbs::symmetric_graph<gbbs::symmetric_vertex, Wgh> Subgraph(size_t i) const {
+    using uintE = gbbs::uintE;
+    size_t first_vertex = vertex_offsets[i];
+    size_t first_edge = edge_offsets[first_vertex];
+    auto subgraph_edges = parlay::sequence<std::tuple<uintE, uintE, Wgh>>::uninitialized(NumEdges(i));
+    parlay::parallel_for(first_vertex, vertex_offsets[i + 1], [&] (size_t x) {
+      parlay::parallel_for(edge_offsets[x], edge_offsets[x + 1], [&] (size_t e) {
+        const auto& [v, wgh] = edges[e];
+        if constexpr(std::is_same_v<Wgh, gbbs::empty>) {
+          subgraph_edges[e - first_edge] = std::tuple<uintE, uintE, gbbs::empty>(x - first_vertex, v, gbbs::empty());
+        } else {
+          subgraph_edges[e - first_edge] = std::tuple<uintE, uintE, Wgh>(x - first_vertex, v, wgh);
+        }
+      });
+    });
+    return gbbs::sym_graph_from_edges(subgraph_edges, vertex_offsets[i + 1] - first_vertex);
+  }
+};
+
+// Returns whether each of the n vertices of the graph is in a cluster of
+// `clustering`. The cluster ids of the other vertices are meaningless, so an
+// edge is only intra-cluster if both of its endpoints are clustered.
+inline parlay::sequence<bool> ClusteredVertices(std::size_t n, const InMemoryClusterer::Clustering& clustering){
+    auto is_clustered = parlay::sequence<bool>(n, false);
+    parlay::parallel_for(0, clustering.size(), [&] (size_t i) {
+      parlay::parallel_for(0, clustering[i].size(), [&] (size_t j) {
+        is_clustered[clustering[i][j]] = true;
+      });
+    });
+    return is_clustered;
 }
 
-// return the number of edges in a subgraph that has the vertices in V
-// labels[i] is the cluster id of vertex i
-inline std::size_t get_subgraph_num_edges(const GbbsGraph& graph_, const std::vector<InMemoryClusterer::NodeId>& V, const parlay::sequence<gbbs::uintE>& labels){
+// Builds the ClusterPartitionedGraph of `clustering`, where labels[i] is the
+// cluster id of vertex i. Vertices outside `clustering` are left out.
+inline ClusterPartitionedGraph PartitionByCluster(const GbbsGraph& graph_, const InMemoryClusterer::Clustering& clustering, const parlay::sequence<gbbs::uintE>& labels){
     using uintE = gbbs::uintE;
-    std::size_t n = V.size();
-    auto offsets = parlay::sequence<size_t>::from_function(
-      n, [&](size_t i) { return graph_.Graph()->get_vertex(V[i]).out_degree(); }); //double check, is numbers in V corresponding to the graph nodes?
-    auto new_m = parlay::scan_inclusive_inplace(offsets);
-    auto flags = parlay::sequence<size_t>(new_m, 0); // flag[i] = true if the edge should be in the subgraph
-    // mark true in flags where an edge is in subgraph
-    parlay::parallel_for(0, n, [&] (size_t i) {
-        uintE vert = V[i];
-        std::size_t offset = i==0 ? 0 : offsets[i-1];
-        auto map_f = [&] (const auto& u, const auto& v, const auto& wgh, const auto& j) {
-            if(labels[u]==labels[v]){
-                flags[offset+j] = 1;
-            }
-        };
-        graph_.Graph()->get_vertex(vert).out_neighbors().map_with_index(map_f);
+    ClusterPartitionedGraph partitioned_graph;
+    auto is_clustered = ClusteredVertices(graph_.Graph()->n, clustering);
+    partitioned_graph.vertex_offsets = parlay::sequence<size_t>::from_function(
+      clustering.size() + 1, [&](size_t i) { return i == clustering.size() ? 0 : clustering[i].size(); });
+    size_t num_vertices = parlay::scan_inplace(partitioned_graph.vertex_offsets);
+    const auto& offsets = partitioned_graph.vertex_offsets;
+
+    // CSR vertex and index in its cluster of each vertex of the graph
+    auto vertices = parlay::sequence<uintE>::uninitialized(num_vertices);
+    auto local_ids = parlay::sequence<uintE>::uninitialized(graph_.Graph()->n);
+    parlay::parallel_for(0, clustering.size(), [&] (size_t i) {
+      parlay::parallel_for(0, clustering[i].size(), [&] (size_t j) {
+        vertices[offsets[i] + j] = clustering[i][j];
+        local_ids[clustering[i][j]] = j;
+      });
     });
 
-    return parlay::reduce(flags);
-
+    partitioned_graph.edge_offsets = parlay::sequence<size_t>::from_function(
+      num_vertices + 1, [&](size_t x) -> size_t {
+        if (x == num_vertices) return 0;
+        return graph_.Graph()->get_vertex(vertices[x]).out_neighbors().count(
+          [&] (const auto& u, const auto& v, const auto& wgh) { return is_clustered[v] && labels[u] == labels[v]; });
+      });
+    size_t num_edges = parlay::scan_inplace(partitioned_graph.edge_offsets);
+
+    partitioned_graph.edges = parlay::sequence<std::tuple<uintE, float>>::uninitialized(num_edges);
+    parlay::parallel_for(0, num_vertices, [&] (size_t x) {
+      size_t e = partitioned_graph.edge_offsets[x];
+      auto map_f = [&] (const auto& u, const auto& v, const auto& wgh) {
+        if(is_clustered[v] && labels[u]==labels[v]){
+          partitioned_graph.edges[e++] = std::make_tuple(local_ids[v], static_cast<float>(wgh));
+        }
+      };
+      graph_.Graph()->get_vertex(vertices[x]).out_neighbors().map(map_f, false);
+    });
+    return partitioned_graph;
 }
 
 template<class Graph>
@@ -0,0 +1,65 @@
+#include "gtest/gtest.h"
+
+#include <set>
+#include <vector>
+
+#include "clusterers/affinity/parallel-affinity.h"
+#include "clusterers/gbbs_graph_io.h"
+#include "parcluster/api/config.pb.h"
+
+namespace research_graph::in_memory {
+namespace {
+
+TEST(TestParallelAffinity, HierarchicalCluster) {
+  // Round 1 (threshold 0.5) merges {0, 1}, {2, 3} and {4, 5, 6}; round 2
+  // (threshold 0.1) merges the first two through the edge {1, 2}.
+  const std::vector<gbbs::gbbs_io::Edge<double>> edge_list = {
+      {0, 1, 0.9}, {2, 3, 0.8}, {1, 2, 0.3}, {4, 5, 0.9}, {5, 6, 0.95}};
+  ParallelAffinityClusterer clusterer;
+  ASSERT_TRUE(internal::WriteEdgeListAsGraph(clusterer.MutableGraph(),
+                                             edge_list, true)
+                  .ok());
+
+  ClustererConfig config;
+  auto* affinity_config = config.mutable_affinity_clusterer_config();
+  affinity_config->set_num_iterations(2);
+  affinity_config->set_edge_aggregation_function(AffinityClustererConfig::MAX);
+  affinity_config->mutable_per_iteration_weight_thresholds()->add_thresholds(
+      0.5);
+  affinity_config->mutable_per_iteration_weight_thresholds()->add_thresholds(
+      0.1);
+  auto dendrogram = clusterer.HierarchicalCluster(config);
+  ASSERT_TRUE(dendrogram.ok());
+
+  const auto kNoParentId = ParallelAffinityClusterer::Dendrogram::kNoParentId;
+  const auto& nodes = dendrogram->Nodes();
+  // 7 leaves, 1 + 1 + 2 merges in round 1 and 1 in round 2.
+  ASSERT_EQ(12, nodes.size());
+  auto parent = [&](gbbs::uintE i) { return nodes[i].parent_id; };
+  auto similarity = [&](gbbs::uintE i) { return nodes[i].merge_similarity; };
+
+  for (gbbs::uintE i = 0; i < 7; i++) {
+    ASSERT_NE(kNoParentId, parent(i)) << i;
+    EXPECT_FLOAT_EQ(0.5, similarity(i)) << i;
+  }
+  EXPECT_EQ(parent(0), parent(1));
+  EXPECT_EQ(parent(2), parent(3));
+  EXPECT_NE(parent(0), parent(2));
+  EXPECT_EQ(parent(parent(0)), parent(parent(2)));
+  EXPECT_FLOAT_EQ(0.1, similarity(parent(0)));
+  EXPECT_FLOAT_EQ(0.1, similarity(parent(2)));
+  EXPECT_EQ(kNoParentId, parent(parent(parent(0))));
+
+  // {4, 5, 6} is a chain of two binary merges: two of the leaves share a
+  // parent, whose parent is that of the third leaf.
+  std::set<gbbs::uintE> parents = {parent(4), parent(5), parent(6)};
+  ASSERT_EQ(2, parents.size());
+  const gbbs::uintE first = *parents.begin();
+  const gbbs::uintE second = *parents.rbegin();
+  EXPECT_EQ(second, parent(first));
+  EXPECT_FLOAT_EQ(0.5, similarity(first));
+  EXPECT_EQ(kNoParentId, parent(second));
+}
+
+}  // namespace
+}  // namespace research_graph::in_memory
@@ -0,0 +1,217 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "clusterers/affinity/parallel-affinity-internal.h"
+#include "clusterers/gbbs_graph_io.h"
+#include "in_memory/status_macros.h"
+#include "parcluster/api/config.pb.h"
+
+namespace research_graph::in_memory {
+namespace {
+
+using EdgeWeights = std::map<std::pair<gbbs::uintE, gbbs::uintE>, float>;
+
+// Returns the weight of every directed edge of `graph`.
+EdgeWeights GetEdgeWeights(
+    gbbs::symmetric_ptr_graph<gbbs::symmetric_vertex, float>& graph) {
+  EdgeWeights result;
+  for (gbbs::uintE i = 0; i < graph.n; i++) {
+    graph.get_vertex(i).out_neighbors().map(
+        [&](gbbs::uintE u, gbbs::uintE v, float weight) {
+          result[{u, v}] = weight;
+        },
+        false);
+  }
+  return result;
+}
+
+// Returns `weights` with both directions of every undirected edge.
+EdgeWeights Symmetric(const EdgeWeights& weights) {
+  EdgeWeights result;
+  for (const auto& [edge, weight] : weights) {
+    result[edge] = weight;
+    result[{edge.second, edge.first}] = weight;
+  }
+  return result;
+}
+
+// Clusters {0, 1}, {2, 3} and {4} with node weights 3, 4 and 1. Vertex 5 is in
+// a finished cluster, and the intra-cluster edge {0, 1} is dropped.
+const std::vector<gbbs::gbbs_io::Edge<double>> kEdges = {
+    {0, 1, 7}, {0, 2, 1}, {1, 2, 2}, {1, 3, 4},
+    {0, 4, 3}, {3, 4, 0.5}, {4, 5, 9}};
+const std::vector<gbbs::uintE> kClusterIds = {0, 0, 1, 1, 2, UINT_E_MAX};
+const std::vector<gbbs::uintE> kNodeWeights = {1, 2, 1, 3, 1, 1};
+
+EdgeWeights Compress(AffinityClustererConfig::EdgeAggregationFunction function) {
+  GbbsGraph graph;
+  EXPECT_TRUE(internal::WriteEdgeListAsGraph(&graph, kEdges, true).status().ok());
+  std::vector<gbbs::uintE> cluster_ids = kClusterIds;
+  std::vector<gbbs::uintE> node_weights = kNodeWeights;
+  AffinityClustererConfig config;
+  config.set_edge_aggregation_function(function);
+  auto compressed =
+      CompressGraph(*graph.Graph(), node_weights, cluster_ids, config);
+  EXPECT_TRUE(compressed.status().ok());
+  if (!compressed.ok()) return {};
+  EXPECT_EQ(std::vector<gbbs::uintE>({3, 4, 1}), compressed->node_weights);
+  return GetEdgeWeights(*compressed->graph);
+}
+
+TEST(TestCompressGraph, Max) {
+  EXPECT_EQ(Symmetric({{{0, 1}, 4}, {{0, 2}, 3}, {{1, 2}, 0.5}}),
+            Compress(AffinityClustererConfig::MAX));
+}
+
+TEST(TestCompressGraph, Sum) {
+  EXPECT_EQ(Symmetric({{{0, 1}, 7}, {{0, 2}, 3}, {{1, 2}, 0.5}}),
+            Compress(AffinityClustererConfig::SUM));
+}
+
+TEST(TestCompressGraph, Average) {
+  // Every edge counts with the product of its endpoints' node weights, and the
+  // total is divided by the product of the clusters' node weights.
+  const auto weights = Compress(AffinityClustererConfig::DEFAULT_AVERAGE);
+  const auto expected =
+      Symmetric({{{0, 1}, (1 * 1 + 2 * 2 + 4 * 6) / 12.0f},
+                 {{0, 2}, 3 / 3.0f},
+                 {{1, 2}, 0.5f * 3 / 4}});
+  ASSERT_EQ(expected.size(), weights.size());
+  for (const auto& [edge, weight] : expected) {
+    EXPECT_FLOAT_EQ(weight, weights.at(edge));
+  }
+}
+
+TEST(TestCompressGraph, CutSparsity) {
+  // Every edge counts with the smaller node weight of its endpoints, and the
+  // total is divided by the smaller node weight of the clusters.
+  const auto weights = Compress(AffinityClustererConfig::CUT_SPARSITY);
+  const auto expected =
+      Symmetric({{{0, 1}, (1 * 1 + 2 * 1 + 4 * 2) / 3.0f},
+                 {{0, 2}, 3 / 1.0f},
+                 {{1, 2}, 0.5f}});
+  ASSERT_EQ(expected.size(), weights.size());
+  for (const auto& [edge, weight] : expected) {
+    EXPECT_FLOAT_EQ(weight, weights.at(edge));
+  }
+}
+
+TEST(TestCompressGraph, HashMatchesSort) {
+  // Integer weights keep every sum exact whichever order the edges of a bundle
+  // are added in.
+  const gbbs::uintE n = 300;
+  std::vector<gbbs::gbbs_io::Edge<double>> edges;
+  for (gbbs::uintE u = 0; u < n; u++) {
+    for (gbbs::uintE k = 1; k <= 5; k++) {
+      gbbs::uintE v = (u * 7 + k * 13) % n;
+      if (u < v) edges.push_back({u, v, static_cast<double>((u + v) % 8 + 1)});
+    }
+  }
+  GbbsGraph graph;
+  ASSERT_TRUE(internal::WriteEdgeListAsGraph(&graph, edges, true).ok());
+  std::vector<gbbs::uintE> cluster_ids(n);
+  std::vector<gbbs::uintE> node_weights(n);
+  for (gbbs::uintE i = 0; i < n; i++) {
+    cluster_ids[i] = i % 11 == 0 ? UINT_E_MAX : i % 17;
+    node_weights[i] = i % 3 + 1;
+  }
+
+  for (auto function : {AffinityClustererConfig::MAX, AffinityClustererConfig::SUM,
+                        AffinityClustererConfig::DEFAULT_AVERAGE,
+                        AffinityClustererConfig::CUT_SPARSITY}) {
+    AffinityClustererConfig config;
+    config.set_edge_aggregation_function(function);
+    auto sorted = CompressGraph(*graph.Graph(), node_weights, cluster_ids,
+                                config, EdgeGrouping::kSort);
+    auto hashed = CompressGraph(*graph.Graph(), node_weights, cluster_ids,
+                                config, EdgeGrouping::kHash);
+    ASSERT_TRUE(sorted.ok());
+    ASSERT_TRUE(hashed.ok());
+    EXPECT_EQ(sorted->node_weights, hashed->node_weights);
+    EXPECT_EQ(GetEdgeWeights(*sorted->graph), GetEdgeWeights(*hashed->graph))
+        << AffinityClustererConfig::EdgeAggregationFunction_Name(function);
+  }
+}
+
+// Compresses a star whose center 0 is one cluster and whose leaves, with edge
+// weights `weights`, are another, and returns the weight of the single
+// compressed edge.
+float CompressStar(const std::vector<float>& weights, double percentile,
+                   int min_edge_count) {
+  std::vector<gbbs::gbbs_io::Edge<double>> edges;
+  for (gbbs::uintE i = 0; i < weights.size(); i++) {
+    edges.push_back({0, i + 1, weights[i]});
+  }
+  GbbsGraph graph;
+  EXPECT_TRUE(internal::WriteEdgeListAsGraph(&graph, edges, true).status().ok());
+  std::vector<gbbs::uintE> cluster_ids(weights.size() + 1, 1);
+  cluster_ids[0] = 0;
+  std::vector<gbbs::uintE> node_weights;
+  AffinityClustererConfig config;
+  config.set_edge_aggregation_function(AffinityClustererConfig::PERCENTILE);
+  config.set_percentile_linkage_value(percentile);
+  config.set_min_edge_count_for_percentile_linkage(min_edge_count);
+  auto compressed =
+      CompressGraph(*graph.Graph(), node_weights, cluster_ids, config);
+  EXPECT_TRUE(compressed.status().ok());
+  if (!compressed.ok()) return -1;
+  const auto result = GetEdgeWeights(*compressed->graph);
+  EXPECT_EQ(2, result.size());
+  EXPECT_EQ(result.at({0, 1}), result.at({1, 0}));
+  return result.at({0, 1});
+}
+
+// Returns the value of `weights` at `percentile`, as the baseline sequential
+// percentile linkage defines it.
+float ExpectedPercentile(std::vector<float> weights, double percentile) {
+  std::size_t k = static_cast<std::size_t>(percentile * (weights.size() - 1));
+  std::nth_element(weights.begin(), weights.begin() + k, weights.end());
+  return weights[k];
+}
+
+TEST(TestCompressGraph, Percentile) {
+  const std::vector<float> weights = {1, 5, 2, 4, 3};
+  EXPECT_EQ(1, CompressStar(weights, 0, 1));
+  EXPECT_EQ(3, CompressStar(weights, 0.5, 1));
+  EXPECT_EQ(4, CompressStar(weights, 0.75, 5));
+  EXPECT_EQ(5, CompressStar(weights, 1, 1));
+  // Bundles with fewer than min_edge_count edges take the maximum.
+  EXPECT_EQ(5, CompressStar(weights, 0, 6));
+  EXPECT_EQ(5, CompressStar(weights, 0.5, 100));
+}
+
+TEST(TestCompressGraph, PercentileLargeBundle) {
+  // More edges than are aggregated sequentially, with every weight repeated
+  // so that quickselect pivots have duplicates.
+  std::vector<float> weights;
+  for (int i = 0; i < 3000; i++) {
+    weights.push_back((i * 7919) % 1000);
+  }
+  for (double percentile : {0.0, 0.1, 0.3, 0.5, 0.9, 1.0}) {
+    EXPECT_EQ(ExpectedPercentile(weights, percentile),
+              CompressStar(weights, percentile, 1))
+        << "percentile = " << percentile;
+  }
+  EXPECT_EQ(999, CompressStar(weights, 0.1, 3001));
+}
+
+TEST(TestCompressGraph, PercentileOutOfRange) {
+  GbbsGraph graph;
+  ASSERT_OK(internal::WriteEdgeListAsGraph(&graph, kEdges, true).status());
+  std::vector<gbbs::uintE> cluster_ids = kClusterIds;
+  std::vector<gbbs::uintE> node_weights = kNodeWeights;
+  AffinityClustererConfig config;
+  config.set_edge_aggregation_function(AffinityClustererConfig::PERCENTILE);
+  config.set_percentile_linkage_value(1.5);
+  EXPECT_EQ(absl::StatusCode::kInvalidArgument,
+            CompressGraph(*graph.Graph(), node_weights, cluster_ids, config)
+                .status()
+                .code());
+}
+
+}  // namespace
+}  // namespace research_graph::in_memory
@@ -141,4 +141,70 @@ TEST(TestEdgeDensity, TestNonClique) {
   EXPECT_DOUBLE_EQ(2.0/3, clustering_stats.edge_density().mean());
 }
 
+TEST(TestEdgeDensity, TestWeighted) {
+  size_t n = 4;
+  std::vector<std::vector<gbbs::uintE>> clustering = {
+      {0, 1, 3},
+      {2},
+  };
+  const std::vector<gbbs::gbbs_io::Edge<double>> edge_list = {
+      {0, 1, 0.5}, {0, 3, 1}};
+
+  parlay::sequence<gbbs::uintE> cluster_ids = GetClusteringIds(n, clustering);
+
+  GbbsGraph graph;
+  ASSERT_OK_AND_ASSIGN(n,
+                       internal::WriteEdgeListAsGraph(&graph, edge_list, true));
+
+  ClusteringStatistics clustering_stats;
+  ClusteringStatsConfig clustering_stats_config;
+  clustering_stats_config.set_compute_weighted_edge_density(true);
+
+  clustering_stats_config.set_include_zero_degree_nodes(true);
+  ASSERT_OK(ComputeEdgeDensity(graph, clustering, &clustering_stats,
+                               cluster_ids, clustering_stats_config));
+  EXPECT_DOUBLE_EQ(0.75, clustering_stats.weighted_edge_density().mean());
+  EXPECT_FALSE(clustering_stats.has_edge_density());
+
+  clustering_stats_config.set_include_zero_degree_nodes(false);
+  ASSERT_OK(ComputeEdgeDensity(graph, clustering, &clustering_stats,
+                               cluster_ids, clustering_stats_config));
+  EXPECT_DOUBLE_EQ(0.5, clustering_stats.weighted_edge_density().mean());
+}
+
+TEST(TestEdgeDensity, TestPartialClustering) {
+  size_t n = 3;
+  // Vertex 0 is in no cluster, but keeps the cluster id 0 of {1, 2}.
+  std::vector<std::vector<gbbs::uintE>> clustering = {
+      {1, 2},
+  };
+  const std::vector<gbbs::gbbs_io::Edge<double>> edge_list = {
+      {0, 1, 0.5}, {1, 2, 0.25}};
+
+  parlay::sequence<gbbs::uintE> cluster_ids = GetClusteringIds(n, clustering);
+
+  GbbsGraph graph;
+  ASSERT_OK_AND_ASSIGN(n,
+                       internal::WriteEdgeListAsGraph(&graph, edge_list, true));
+
+  ClusteringStatistics clustering_stats;
+  ClusteringStatsConfig clustering_stats_config;
+  clustering_stats_config.set_compute_edge_density(true);
+  clustering_stats_config.set_compute_weighted_edge_density(true);
+  clustering_stats_config.set_include_zero_degree_nodes(true);
+
+  ASSERT_OK(ComputeEdgeDensity(graph, clustering, &clustering_stats,
+                               cluster_ids, clustering_stats_config));
+  EXPECT_EQ(1, clustering_stats.edge_density().count());
+  EXPECT_EQ(1, clustering_stats.edge_density().mean());
+  EXPECT_DOUBLE_EQ(0.25, clustering_stats.weighted_edge_density().mean());
+
+  // No vertex is clustered.
+  clustering.clear();
+  clustering_stats.Clear();
+  ASSERT_OK(ComputeEdgeDensity(graph, clustering, &clustering_stats,
+                               cluster_ids, clustering_stats_config));
+  EXPECT_EQ(0, clustering_stats.edge_density().count());
+}
+
 } // namespace research_graph::in_memory
@@ -1,6 +1,8 @@
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 
+#include <fstream>
+#include <string>
 #include <vector>
 
 #include "clusterers/labelprop_clusterer/labelprop-clusterer.h"
@@ -223,4 +225,107 @@ TEST(TestLP, MajorityUnweighted) {
   clustering = *result;
   EXPECT_THAT(clustering, UnorderedElementsAre(UnorderedElementsAre(0, 1, 2, 3)));
 
-}
\ No newline at end of file
+}
+
+TEST(TestLP, WarmStart) {
+  std::unique_ptr<InMemoryClusterer> clusterer;
+  clusterer.reset(new LabelPropagationClusterer);
+  // Two triangles joined by the edge {2, 3}.
+  const std::vector<gbbs::gbbs_io::Edge<gbbs::empty>> edge_list = {
+      {0, 1}, {0, 2}, {1, 2}, {2, 3}, {3, 4}, {3, 5}, {4, 5}};
+
+  auto n_status =  WriteEdgeListAsGraph(clusterer->MutableGraph(), edge_list, 
+                                        /*is_symmetric_graph*/true);
+
+  research_graph::in_memory::LabelPropagationClustererConfig labelprop_config;
+  labelprop_config.set_max_iteration(100);
+  labelprop_config.set_update_threshold(0);
+  labelprop_config.set_par_threshold(300);
+  labelprop_config.set_async(false);
+  for (gbbs::uintE label : {0, 0, 0, 0, 1, 1}) {
+    labelprop_config.add_seed_labels(label);
+  }
+
+  ClustererConfig config;
+  google::protobuf::Any* any = config.mutable_any_config();
+  any->PackFrom(labelprop_config);
+  auto result = clusterer->Cluster(config);
+  auto clustering = *result;
+
+  EXPECT_THAT(clustering, UnorderedElementsAre(UnorderedElementsAre(0, 1, 2), UnorderedElementsAre(3, 4, 5)));
+
+  // Only node 5 is revisited, and it already agrees with its neighbors.
+  labelprop_config.add_initial_active_nodes(5);
+  any->PackFrom(labelprop_config);
+  result = clusterer->Cluster(config);
+  clustering = *result;
+
+  EXPECT_THAT(clustering, UnorderedElementsAre(UnorderedElementsAre(0, 1, 2, 3), UnorderedElementsAre(4, 5)));
+
+  // Node 3 is unseeded and free to join its heavier neighborhood.
+  labelprop_config.clear_initial_active_nodes();
+  labelprop_config.set_pin_seed_labels(true);
+  labelprop_config.set_seed_labels(3, 4294967295u);
+  any->PackFrom(labelprop_config);
+  result = clusterer->Cluster(config);
+  clustering = *result;
+
+  EXPECT_THAT(clustering, UnorderedElementsAre(UnorderedElementsAre(0, 1, 2), UnorderedElementsAre(3, 4, 5)));
+}
+
+TEST(TestLP, PinSeedLabels) {
+  std::unique_ptr<InMemoryClusterer> clusterer;
+  clusterer.reset(new LabelPropagationClusterer);
+  // Node 1 is seeded with 0 but two of its three neighbors are seeded with 4
+  // and 5. Nodes 2 and 3 are unseeded.
+  const std::vector<gbbs::gbbs_io::Edge<gbbs::empty>> edge_list = {
+      {0, 2}, {1, 2}, {1, 4}, {1, 5}, {2, 3}, {3, 4}, {3, 5}};
+
+  auto n_status =  WriteEdgeListAsGraph(clusterer->MutableGraph(), edge_list, 
+                                        /*is_symmetric_graph*/true);
+
+  research_graph::in_memory::LabelPropagationClustererConfig labelprop_config;
+  labelprop_config.set_max_iteration(100);
+  labelprop_config.set_update_threshold(0);
+  labelprop_config.set_par_threshold(300);
+  labelprop_config.set_async(false);
+  labelprop_config.set_pin_seed_labels(true);
+  for (gbbs::uintE label : {0u, 0u, 4294967295u, 4294967295u, 1u, 1u}) {
+    labelprop_config.add_seed_labels(label);
+  }
+
+  ClustererConfig config;
+  google::protobuf::Any* any = config.mutable_any_config();
+  any->PackFrom(labelprop_config);
+  auto result = clusterer->Cluster(config);
+  ASSERT_TRUE(result.ok());
+  auto clustering = *result;
+
+  // The unpinned nodes 2 and 3 leave their singletons for their heaviest
+  // neighborhoods, while the pinned node 1 keeps its seed label.
+  EXPECT_THAT(clustering, UnorderedElementsAre(UnorderedElementsAre(0, 1, 2), UnorderedElementsAre(3, 4, 5)));
+}
+
+TEST(TestLP, MalformedSeedFile) {
+  std::unique_ptr<InMemoryClusterer> clusterer;
+  clusterer.reset(new LabelPropagationClusterer);
+  const std::vector<gbbs::gbbs_io::Edge<gbbs::empty>> edge_list = {{0, 1}, {1, 2}};
+
+  auto n_status =  WriteEdgeListAsGraph(clusterer->MutableGraph(), edge_list, 
+                                        /*is_symmetric_graph*/true);
+
+  research_graph::in_memory::LabelPropagationClustererConfig labelprop_config;
+  ClustererConfig config;
+  google::protobuf::Any* any = config.mutable_any_config();
+
+  const std::string filename = ::testing::TempDir() + "/labelprop_seed.txt";
+  for (const std::string contents : {"0\t1x\n", "0\t99999999999999999999\n", "0\t3\n"}) {
+    std::ofstream file(filename);
+    file << contents;
+    file.close();
+    labelprop_config.set_seed_clustering_file(filename);
+    any->PackFrom(labelprop_config);
+    auto result = clusterer->Cluster(config);
+    EXPECT_EQ(absl::StatusCode::kInvalidArgument, result.status().code()) << contents;
+  }
+}
@@ -0,0 +1,185 @@
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "clusterers/scan_clusterer/scan-clusterer.h"
+#include "clusterers/scan_clusterer/scan_config.pb.h"
+#include "google/protobuf/any.pb.h"
+
+#include "clusterers/gbbs_graph_io.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+
+using research_graph::in_memory::ScanClusterer;
+using research_graph::in_memory::ScanClustererConfig;
+using research_graph::in_memory::ClustererConfig;
+using research_graph::in_memory::internal::WriteEdgeListAsGraph;
+
+using testing::UnorderedElementsAre;
+
+namespace {
+
+// Two triangles {0, 1, 2} and {3, 4, 5} joined by the edge {2, 3}. With
+// closed neighborhoods, the cosine similarities are 1 within {0, 1} and
+// {4, 5}, 3 / sqrt(12) from 2 and 3 to their triangles and 0.5 on {2, 3}; the
+// Jaccard similarities are 1, 0.75 and 1/3.
+const std::vector<gbbs::gbbs_io::Edge<gbbs::empty>> kTwoTriangles = {
+    {0, 1}, {0, 2}, {1, 2}, {2, 3}, {3, 4}, {3, 5}, {4, 5}};
+
+ClustererConfig MakeConfig(const ScanClustererConfig& scan_config) {
+  ClustererConfig config;
+  config.mutable_any_config()->PackFrom(scan_config);
+  return config;
+}
+
+// Returns the number of lines of `filename`.
+int NumLines(const std::string& filename) {
+  std::ifstream file(filename);
+  int num_lines = 0;
+  std::string line;
+  while (std::getline(file, line)) num_lines++;
+  return num_lines;
+}
+
+}  // namespace
+
+TEST(TestScan, SimilarityMeasure) {
+  ScanClusterer clusterer;
+  auto n_status = WriteEdgeListAsGraph(clusterer.MutableGraph(), kTwoTriangles,
+                                       /*is_symmetric_graph*/true);
+
+  ScanClustererConfig scan_config;
+  scan_config.set_mu(2);
+  scan_config.set_epsilon(0.4);
+  scan_config.set_get_deterministic_result(true);
+  auto clustering = clusterer.Cluster(MakeConfig(scan_config));
+  ASSERT_TRUE(clustering.ok());
+  EXPECT_THAT(*clustering, UnorderedElementsAre(UnorderedElementsAre(0, 1, 2, 3, 4, 5)));
+
+  scan_config.set_similarity_measure(ScanClustererConfig::JACCARD);
+  clustering = clusterer.Cluster(MakeConfig(scan_config));
+  ASSERT_TRUE(clustering.ok());
+  EXPECT_THAT(*clustering, UnorderedElementsAre(UnorderedElementsAre(0, 1, 2), UnorderedElementsAre(3, 4, 5)));
+}
+
+TEST(TestScan, Sweep) {
+  ScanClusterer clusterer;
+  auto n_status = WriteEdgeListAsGraph(clusterer.MutableGraph(), kTwoTriangles,
+                                       /*is_symmetric_graph*/true);
+
+  ScanClustererConfig scan_config;
+  scan_config.add_mus(2);
+  scan_config.add_mus(3);
+  scan_config.add_epsilons(0.8);
+  scan_config.add_epsilons(0.4);
+  scan_config.set_get_deterministic_result(true);
+
+  std::map<std::pair<int64_t, float>, ScanClusterer::Clustering> clusterings;
+  ASSERT_TRUE(clusterer.ClusterAll(MakeConfig(scan_config),
+      [&](int64_t mu, float epsilon, ScanClusterer::Clustering&& clustering) {
+        clusterings[{mu, epsilon}] = std::move(clustering);
+        return absl::OkStatus();
+      }).ok());
+  ASSERT_EQ(4, clusterings.size());
+
+  // Each clustering of the sweep is the one of its own (mu, epsilon) pair.
+  for (const auto& [parameters, clustering] : clusterings) {
+    ScanClustererConfig single_config;
+    single_config.set_mu(parameters.first);
+    single_config.set_epsilon(parameters.second);
+    single_config.set_get_deterministic_result(true);
+    auto expected = clusterer.Cluster(MakeConfig(single_config));
+    ASSERT_TRUE(expected.ok());
+    EXPECT_EQ(*expected, clustering) << "mu = " << parameters.first << ", epsilon = " << parameters.second;
+  }
+
+  // Cluster() writes every pair and returns the first one.
+  const std::string prefix = ::testing::TempDir() + "/scan_sweep";
+  scan_config.set_sweep_output_prefix(prefix);
+  auto first = clusterer.Cluster(MakeConfig(scan_config));
+  ASSERT_TRUE(first.ok());
+  EXPECT_EQ(clusterings[{2, 0.8f}], *first);
+  for (const auto& [parameters, clustering] : clusterings) {
+    const std::string filename =
+        absl::StrCat(prefix, "-mu", parameters.first, "-eps", parameters.second);
+    EXPECT_EQ(clustering.size(), NumLines(filename)) << filename;
+  }
+}
+
+TEST(TestScan, SweepOutputPrefix) {
+  ScanClusterer clusterer;
+  auto n_status = WriteEdgeListAsGraph(clusterer.MutableGraph(), kTwoTriangles,
+                                       /*is_symmetric_graph*/true);
+
+  // More than one (mu, epsilon) pair needs somewhere to write them.
+  ScanClustererConfig scan_config;
+  scan_config.add_mus(2);
+  scan_config.add_mus(3);
+  EXPECT_EQ(absl::StatusCode::kInvalidArgument,
+            clusterer.Cluster(MakeConfig(scan_config)).status().code());
+
+  // A single pair does not.
+  scan_config.clear_mus();
+  scan_config.add_epsilons(0.4);
+  EXPECT_TRUE(clusterer.Cluster(MakeConfig(scan_config)).ok());
+
+  scan_config.set_mu(0);
+  EXPECT_EQ(absl::StatusCode::kInvalidArgument,
+            clusterer.Cluster(MakeConfig(scan_config)).status().code());
+}
+
+namespace {
+
+// Returns the contents of `filename`.
+std::string ReadFile(const std::string& filename) {
+  std::ifstream file(filename);
+  return std::string(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+}
+
+}  // namespace
+
+TEST(TestScan, UnclusteredTypes) {
+  // Cliques {0, 1, 2, 3} and {5, 6, 7, 8}. Vertex 4 bridges them with cosine
+  // similarity 2 / sqrt(15) ~ 0.52 to both, and vertex 9 hangs off vertex 8
+  // with similarity 2 / sqrt(10) ~ 0.63.
+  std::vector<gbbs::gbbs_io::Edge<gbbs::empty>> edge_list = {
+      {0, 4}, {4, 5}, {8, 9}};
+  for (gbbs::uintE offset : {0, 5}) {
+    for (gbbs::uintE u = 0; u < 4; u++) {
+      for (gbbs::uintE v = u + 1; v < 4; v++) {
+        edge_list.push_back({offset + u, offset + v});
+      }
+    }
+  }
+  ScanClusterer clusterer;
+  auto n_status = WriteEdgeListAsGraph(clusterer.MutableGraph(), edge_list,
+                                       /*is_symmetric_graph*/true);
+
+  const std::string filename = ::testing::TempDir() + "/scan_unclustered";
+  ScanClustererConfig scan_config;
+  scan_config.set_mu(3);
+  scan_config.set_epsilon(0.7);
+  scan_config.set_unclustered_output_file(filename);
+  auto clustering = clusterer.Cluster(MakeConfig(scan_config));
+  ASSERT_TRUE(clustering.ok());
+  // Vertex 4 touches both clusters, while vertex 9 only touches one.
+  EXPECT_EQ("4\thub\n9\toutlier\n", ReadFile(filename));
+
+  // Each pair of a sweep has its own file. At epsilon 0.6, vertex 9 joins its
+  // neighbor's cluster.
+  scan_config.add_epsilons(0.7);
+  scan_config.add_epsilons(0.6);
+  scan_config.set_sweep_output_prefix(::testing::TempDir() + "/scan_clusters");
+  clustering = clusterer.Cluster(MakeConfig(scan_config));
+  ASSERT_TRUE(clustering.ok());
+  EXPECT_EQ("4\thub\n9\toutlier\n", ReadFile(filename + "-mu3-eps0.7"));
+  EXPECT_EQ("4\thub\n", ReadFile(filename + "-mu3-eps0.6"));
+}
@@ -0,0 +1,161 @@
+#include "gtest/gtest.h"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "clusterers/gbbs_graph_io.h"
+#include "clusterers/scan_clusterer/IndexBased/scan.h"
+#include "clusterers/scan_clusterer/IndexBased/utils.h"
+#include "in_memory/status_macros.h"
+
+namespace research_graph::in_memory {
+namespace {
+
+using gbbs::indexed_scan::Index;
+
+// Two triangles {0, 1, 2} and {3, 4, 5} joined by the edge {2, 3}, next to an
+// 8-cycle on vertices 6 to 13, in which every vertex has the same
+// similarities.
+std::vector<gbbs::gbbs_io::Edge<gbbs::empty>> TestEdges() {
+  std::vector<gbbs::gbbs_io::Edge<gbbs::empty>> edges = {
+      {0, 1}, {0, 2}, {1, 2}, {2, 3}, {3, 4}, {3, 5}, {4, 5}};
+  for (gbbs::uintE i = 0; i < 8; i++) {
+    edges.push_back({6 + i, 6 + (i + 1) % 8});
+  }
+  return edges;
+}
+
+const std::vector<float> kEpsilons = {0.9, 0.8, 0.6, 0.5, 0.4, 0.3};
+
+std::string ReadFile(const std::string& filename) {
+  std::ifstream file{filename, std::ios::binary};
+  return std::string(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const std::string& filename, const std::string& contents) {
+  std::ofstream file{filename, std::ios::binary | std::ios::trunc};
+  file << contents;
+}
+
+// Relabels every cluster of `clustering` by its smallest vertex, so that
+// clusterings can be compared regardless of their cluster IDs.
+gbbs::scan::Clustering Canonical(const gbbs::scan::Clustering& clustering) {
+  std::vector<gbbs::uintE> representative(clustering.size(),
+                                          gbbs::indexed_scan::kUnclustered);
+  for (gbbs::uintE v = 0; v < clustering.size(); v++) {
+    if (clustering[v] != gbbs::indexed_scan::kUnclustered &&
+        representative[clustering[v]] == gbbs::indexed_scan::kUnclustered) {
+      representative[clustering[v]] = v;
+    }
+  }
+  return gbbs::scan::Clustering::from_function(
+      clustering.size(), [&](size_t v) {
+        return clustering[v] == gbbs::indexed_scan::kUnclustered
+                   ? gbbs::indexed_scan::kUnclustered
+                   : representative[clustering[v]];
+      });
+}
+
+// Checks that clustering with all of `kEpsilons` at once matches clustering
+// with each of them on its own.
+void ExpectSameAsSingleEpsilon(const Index& index, uint64_t mu) {
+  const auto epsilons = parlay::sequence<float>(kEpsilons.begin(),
+                                                kEpsilons.end());
+  size_t num_calls = 0;
+  index.Cluster(
+      mu, epsilons,
+      [&](gbbs::scan::Clustering&& clustering, size_t i) {
+        num_calls++;
+        EXPECT_EQ(Canonical(index.Cluster(mu, epsilons[i], true)),
+                  Canonical(clustering))
+            << "mu = " << mu << ", epsilon = " << epsilons[i];
+      },
+      true);
+  EXPECT_EQ(kEpsilons.size(), num_calls);
+}
+
+TEST(TestScanIndex, SeveralEpsilons) {
+  GbbsGraph graph;
+  ASSERT_OK(internal::WriteEdgeListAsGraph(&graph, TestEdges(), true).status());
+
+  // mu = 2 and 3 are precomputed, while 1 and 4 are not and are cached on
+  // first use.
+  const Index index{graph.Graph(), gbbs::scan::CosineSimilarity{},
+                    {.min_mu = 2, .max_mu = 3}};
+  for (uint64_t mu : {1, 2, 3, 4, 4, 5}) {
+    ExpectSameAsSingleEpsilon(index, mu);
+  }
+
+  // With a budget too small for any thresholds, nothing is precomputed or
+  // cached and every mu is computed again on each use.
+  const Index over_budget_index{graph.Graph(), gbbs::scan::CosineSimilarity{},
+                                {.max_bytes = 1}};
+  for (uint64_t mu : {2, 3, 3}) {
+    ExpectSameAsSingleEpsilon(over_budget_index, mu);
+  }
+}
+
+TEST(TestScanIndex, SaveAndLoad) {
+  GbbsGraph graph;
+  ASSERT_OK(internal::WriteEdgeListAsGraph(&graph, TestEdges(), true).status());
+  const uint64_t fingerprint = gbbs::scan::GraphFingerprint(graph.Graph());
+  const Index index{graph.Graph(), gbbs::scan::CosineSimilarity{},
+                    {.min_mu = 2, .max_mu = 3}};
+
+  const std::string filename = ::testing::TempDir() + "/scan_index";
+  ASSERT_TRUE(index.Save(filename, fingerprint));
+  const auto loaded = Index::Load(filename, fingerprint);
+  ASSERT_NE(nullptr, loaded);
+  // mu = 4 is not stored in the file and is computed on first use.
+  for (uint64_t mu : {2, 3, 4}) {
+    for (float epsilon : kEpsilons) {
+      EXPECT_EQ(index.Cluster(mu, epsilon, true),
+                loaded->Cluster(mu, epsilon, true))
+          << "mu = " << mu << ", epsilon = " << epsilon;
+    }
+  }
+}
+
+TEST(TestScanIndex, LoadRejectsMismatchedFiles) {
+  GbbsGraph graph;
+  ASSERT_OK(internal::WriteEdgeListAsGraph(&graph, TestEdges(), true).status());
+  const uint64_t fingerprint = gbbs::scan::GraphFingerprint(graph.Graph());
+  const Index index{graph.Graph()};
+  const std::string filename = ::testing::TempDir() + "/scan_index_mismatch";
+  ASSERT_TRUE(index.Save(filename, fingerprint));
+  const std::string contents = ReadFile(filename);
+
+  EXPECT_EQ(nullptr, Index::Load(filename, fingerprint + 1));
+  EXPECT_EQ(nullptr,
+            Index::Load(::testing::TempDir() + "/scan_index_missing",
+                        fingerprint));
+
+  // An index of another graph has another fingerprint.
+  GbbsGraph other_graph;
+  auto other_edges = TestEdges();
+  other_edges.pop_back();
+  ASSERT_OK(
+      internal::WriteEdgeListAsGraph(&other_graph, other_edges, true).status());
+  EXPECT_NE(fingerprint, gbbs::scan::GraphFingerprint(other_graph.Graph()));
+
+  const std::string truncated_filename = filename + "_truncated";
+  WriteFile(truncated_filename, contents.substr(0, contents.size() - 1));
+  EXPECT_EQ(nullptr, Index::Load(truncated_filename, fingerprint));
+  WriteFile(truncated_filename, contents.substr(0, 16));
+  EXPECT_EQ(nullptr, Index::Load(truncated_filename, fingerprint));
+
+  const std::string bad_magic_filename = filename + "_bad_magic";
+  std::string bad_magic = contents;
+  bad_magic[0] ^= 1;
+  WriteFile(bad_magic_filename, bad_magic);
+  EXPECT_EQ(nullptr, Index::Load(bad_magic_filename, fingerprint));
+
+  // The untouched copy still loads.
+  EXPECT_NE(nullptr, Index::Load(filename, fingerprint));
+}
+
+}  // namespace
+}  // namespace research_graph::in_memory
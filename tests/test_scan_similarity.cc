@@ -0,0 +1,95 @@
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "clusterers/gbbs_graph_io.h"
+#include "clusterers/scan_clusterer/IndexBased/similarity_measure.h"
+#include "in_memory/status_macros.h"
+
+namespace research_graph::in_memory {
+namespace {
+
+// Triangle {0, 1, 2} with a pendant vertex 3 on vertex 2, with the closed
+// neighborhoods (self-loop weight 1)
+//   N[0] = {0: 1, 1: 2, 2: 1}
+//   N[1] = {0: 2, 1: 1, 2: 0.5}
+//   N[2] = {0: 1, 1: 0.5, 2: 1, 3: 4}
+//   N[3] = {2: 4, 3: 1}.
+const std::vector<gbbs::gbbs_io::Edge<double>> kWeightedEdges = {
+    {0, 1, 2}, {0, 2, 1}, {1, 2, 0.5}, {2, 3, 4}};
+
+// Returns the similarity of every (source, neighbor) pair in `similarities`.
+std::map<std::pair<gbbs::uintE, gbbs::uintE>, float> ToMap(
+    const parlay::sequence<gbbs::scan::EdgeSimilarity>& similarities) {
+  std::map<std::pair<gbbs::uintE, gbbs::uintE>, float> result;
+  for (const auto& edge : similarities) {
+    result[{edge.source, edge.neighbor}] = edge.similarity;
+  }
+  return result;
+}
+
+// Checks that `similarities` has `expected[{u, v}]` in both directions of
+// every edge {u, v}.
+void ExpectSimilarities(
+    const parlay::sequence<gbbs::scan::EdgeSimilarity>& similarities,
+    const std::map<std::pair<gbbs::uintE, gbbs::uintE>, double>& expected) {
+  const auto actual = ToMap(similarities);
+  EXPECT_EQ(2 * expected.size(), actual.size());
+  for (const auto& [edge, similarity] : expected) {
+    const auto [u, v] = edge;
+    ASSERT_EQ(1, actual.count({u, v})) << u << " " << v;
+    ASSERT_EQ(1, actual.count({v, u})) << v << " " << u;
+    EXPECT_NEAR(similarity, actual.at({u, v}), 1e-6) << u << " " << v;
+    EXPECT_NEAR(similarity, actual.at({v, u}), 1e-6) << v << " " << u;
+  }
+}
+
+TEST(TestScanSimilarity, WeightedCosine) {
+  GbbsGraph graph;
+  ASSERT_OK(internal::WriteEdgeListAsGraph(&graph, kWeightedEdges, true)
+                .status());
+  // Squared norms: 6, 5.25, 18.25 and 17.
+  ExpectSimilarities(
+      gbbs::scan::WeightedCosineSimilarity{}.AllEdges(graph.Graph()),
+      {{{0, 1}, 4.5 / std::sqrt(6 * 5.25)},
+       {{0, 2}, 3 / std::sqrt(6 * 18.25)},
+       {{1, 2}, 3 / std::sqrt(5.25 * 18.25)},
+       {{2, 3}, 8 / std::sqrt(18.25 * 17)}});
+}
+
+TEST(TestScanSimilarity, WeightedJaccard) {
+  GbbsGraph graph;
+  ASSERT_OK(internal::WriteEdgeListAsGraph(&graph, kWeightedEdges, true)
+                .status());
+  ExpectSimilarities(
+      gbbs::scan::WeightedJaccardSimilarity{}.AllEdges(graph.Graph()),
+      {{{0, 1}, 2.5 / 5},
+       {{0, 2}, 2.5 / 8},
+       {{1, 2}, 2.0 / 8},
+       {{2, 3}, 2 / 9.5}});
+}
+
+TEST(TestScanSimilarity, UnitWeightsMatchUnweighted) {
+  // With every weight 1, the weighted measures are the set-based ones: for
+  // edge {2, 3}, |N[2] & N[3]| = 2, |N[2]| = 4 and |N[3]| = 2.
+  const std::vector<gbbs::gbbs_io::Edge<double>> edges = {
+      {0, 1, 1}, {0, 2, 1}, {1, 2, 1}, {2, 3, 1}};
+  GbbsGraph graph;
+  ASSERT_OK(internal::WriteEdgeListAsGraph(&graph, edges, true).status());
+  ExpectSimilarities(
+      gbbs::scan::WeightedCosineSimilarity{}.AllEdges(graph.Graph()),
+      {{{0, 1}, 3 / std::sqrt(3 * 3)},
+       {{0, 2}, 3 / std::sqrt(3 * 4)},
+       {{1, 2}, 3 / std::sqrt(3 * 4)},
+       {{2, 3}, 2 / std::sqrt(4 * 2)}});
+  ExpectSimilarities(
+      gbbs::scan::WeightedJaccardSimilarity{}.AllEdges(graph.Graph()),
+      {{{0, 1}, 3.0 / 3}, {{0, 2}, 3.0 / 4}, {{1, 2}, 3.0 / 4},
+       {{2, 3}, 2.0 / 4}});
+}
+
+}  // namespace
+}  // namespace research_graph::in_memory
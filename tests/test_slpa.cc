@@ -1,6 +1,7 @@
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 
+#include <string>
 #include <vector>
 #include <set>
 
@@ -91,15 +92,88 @@ TEST(TestLP, TestTwoEdgesGraph) {
 }
 
 
+// Returns the number of rounds reported by a run of `clusterer` with
+// `slpa_config`.
+int NumIterations(InMemoryClusterer* clusterer, const SLPAClustererConfig& slpa_config) {
+  ClustererConfig config;
+  config.mutable_any_config()->PackFrom(slpa_config);
+  testing::internal::CaptureStdout();
+  auto result = clusterer->Cluster(config);
+  std::string output = testing::internal::GetCapturedStdout();
+  EXPECT_TRUE(result.ok());
+  const std::string prefix = "Num iterations: ";
+  auto pos = output.find(prefix);
+  if (pos == std::string::npos) return -1;
+  return std::stoi(output.substr(pos + prefix.size()));
+}
+
+TEST(TestLP, EarlyStopping) {
+  std::unique_ptr<InMemoryClusterer> clusterer;
+  clusterer.reset(new SLPAClusterer);
+  const std::vector<gbbs::gbbs_io::Edge<gbbs::empty>> edge_list = {{0, 1}, {0, 2}};
+
+  auto n_status =  WriteEdgeListAsGraph(clusterer->MutableGraph(), edge_list, 
+                                        /*is_symmetric_graph*/true);
+
+  research_graph::in_memory::SLPAClustererConfig slpa_config;
+  slpa_config.set_max_iteration(300);
+  slpa_config.set_par_threshold(300);
+  slpa_config.set_remove_nested(false);
+  slpa_config.set_seed(1234);
+  EXPECT_EQ(300, NumIterations(clusterer.get(), slpa_config));
+
+  // Every round counts as converged, so the run stops once the window is full.
+  slpa_config.set_convergence_threshold(1);
+  for (int window : {1, 2, 5}) {
+    slpa_config.set_convergence_window(window);
+    EXPECT_EQ(window, NumIterations(clusterer.get(), slpa_config));
+  }
+
+  // Stopping early gives the same clustering as running that many rounds.
+  slpa_config.set_convergence_window(2);
+  ClustererConfig config;
+  google::protobuf::Any* any = config.mutable_any_config();
+  any->PackFrom(slpa_config);
+  auto early = clusterer->Cluster(config);
+  slpa_config.clear_convergence_threshold();
+  slpa_config.set_max_iteration(2);
+  any->PackFrom(slpa_config);
+  auto full = clusterer->Cluster(config);
+  EXPECT_EQ(*early, *full);
+}
+
+TEST(TestLP, EarlyStoppingFraction) {
+  std::unique_ptr<InMemoryClusterer> clusterer;
+  clusterer.reset(new SLPAClusterer);
+  const std::vector<gbbs::gbbs_io::Edge<gbbs::empty>> edge_list = {{0, 1}};
+
+  auto n_status =  WriteEdgeListAsGraph(clusterer->MutableGraph(), edge_list, 
+                                        /*is_symmetric_graph*/true);
+
+  research_graph::in_memory::SLPAClustererConfig slpa_config;
+  slpa_config.set_max_iteration(300);
+  slpa_config.set_par_threshold(300);
+  slpa_config.set_seed(1234);
+  slpa_config.set_convergence_window(1);
+
+  // In the first round, node 1 hears label 0 and its top label becomes 0 on
+  // the tie, while node 0 keeps label 0: half of the top labels change.
+  slpa_config.set_convergence_threshold(0.5);
+  EXPECT_EQ(1, NumIterations(clusterer.get(), slpa_config));
+
+  slpa_config.set_convergence_threshold(0.4);
+  EXPECT_LT(1, NumIterations(clusterer.get(), slpa_config));
+}
+
+
 TEST(TestPostprocessing, TestThreshold) {
   SLPAClusterer clusterer;
 
-  parlay::sequence<std::map<gbbs::uintE, size_t>> memory(2);
-  memory[0][0] = 10;
-  memory[0][1] = 1;
-  memory[0][2] = 11;
+  parlay::sequence<SLPAClusterer::LabelMemory> memory(2);
+  // Cumulative counts: label 0 occurs 10 times, 1 once and 2 11 times.
+  memory[0] = {{0, 10}, {1, 11}, {2, 22}};
 
-  memory[1][1] = 22;
+  memory[1] = {{1, 22}};
 
   // cluster 0: 0
   // cluster 1: 1
@@ -117,14 +191,13 @@ TEST(TestPostprocessing, TestThreshold) {
 TEST(TestPostprocessing, TestMoreClusters) {
   SLPAClusterer clusterer;
 
-  parlay::sequence<std::map<gbbs::uintE, size_t>> memory(3);
-  memory[0][0] = 10;
-  memory[0][1] = 1;
-  memory[0][2] = 11;
+  parlay::sequence<SLPAClusterer::LabelMemory> memory(3);
+  // Cumulative counts: label 0 occurs 10 times, 1 once and 2 11 times.
+  memory[0] = {{0, 10}, {1, 11}, {2, 22}};
 
-  memory[1][1] = 22;
+  memory[1] = {{1, 22}};
 
-  memory[2][1] = 22;
+  memory[2] = {{1, 22}};
 
 
   // cluster 0: 0
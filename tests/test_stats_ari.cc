@@ -8,6 +8,8 @@
 #include "clusterers/clustering_stats.pb.h"
 
 using research_graph::in_memory::ComputeARI;
+using research_graph::in_memory::ComputeContingencyTable;
+using research_graph::in_memory::ComputePairPrecisionRecall;
 using research_graph::in_memory::ClusteringStatistics;
 using research_graph::in_memory::ClusteringStatsConfig;
 
@@ -117,4 +119,31 @@ TEST(TestARI, TestDifferentGridNum) {
   auto status = ComputeARI(n, clustering, &clustering_stats, communities, clustering_stats_config);
   ASSERT_TRUE(status.ok());
   EXPECT_DOUBLE_EQ(-1.0/17, clustering_stats.ari());
-}
\ No newline at end of file
+}
+
+TEST(TestPairPrecisionRecall, TestDifferentGridNum) {
+  // The contingency grid is
+  //  1 2
+  //  4 3
+  std::vector<std::vector<gbbs::uintE>> clustering = {
+    { 1, 2, 3 }, // first cluster
+    { 4, 5, 6, 7, 8, 9, 10 }  // second cluster
+};
+  std::vector<std::vector<gbbs::uintE>> communities  = {
+    { 1, 7, 8, 9, 10}, // first cluster
+    { 2, 3, 4, 5, 6}, // second cluster
+};
+  ClusteringStatistics clustering_stats;
+  ClusteringStatsConfig clustering_stats_config;
+  clustering_stats_config.set_compute_pair_precision_recall(true);
+  auto status = ComputePairPrecisionRecall(
+      ComputeContingencyTable(clustering, communities), &clustering_stats,
+      clustering_stats_config);
+  ASSERT_TRUE(status.ok());
+  EXPECT_EQ(10, clustering_stats.pair_true_positives());
+  EXPECT_EQ(14, clustering_stats.pair_false_positives());
+  EXPECT_EQ(10, clustering_stats.pair_false_negatives());
+  EXPECT_DOUBLE_EQ(10.0/24, clustering_stats.pair_precision());
+  EXPECT_DOUBLE_EQ(0.5, clustering_stats.pair_recall());
+  EXPECT_DOUBLE_EQ(2 * (10.0/24) * 0.5 / (10.0/24 + 0.5), clustering_stats.pair_f_score());
+}
@@ -0,0 +1,102 @@
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "clusterers/stats/stats_communities.h"
+#include "clusterers/clustering_stats.pb.h"
+
+using research_graph::in_memory::CompareCommunities;
+using research_graph::in_memory::ClusteringStatistics;
+using research_graph::in_memory::ClusteringStatsConfig;
+
+namespace {
+
+// Compares the single community `community` with `clustering` and returns
+// the statistics.
+ClusteringStatistics CompareCommunity(
+    std::vector<gbbs::uintE> community,
+    const std::vector<std::vector<gbbs::uintE>>& clustering) {
+  std::vector<std::vector<gbbs::uintE>> communities = {community};
+  ClusteringStatistics clustering_stats;
+  ClusteringStatsConfig clustering_stats_config;
+  clustering_stats_config.set_compute_precision_recall(true);
+  auto status = CompareCommunities(communities, clustering, &clustering_stats,
+                                   clustering_stats_config);
+  EXPECT_TRUE(status.ok());
+  return clustering_stats;
+}
+
+}  // namespace
+
+TEST(TestCommunities, OverlappingClusters) {
+  std::vector<std::vector<gbbs::uintE>> clustering = {
+    { 0, 1, 2, 3 },
+    { 2, 3, 4 },
+    { 5 }
+  };
+  // {2, 3, 4} shares 2 vertices with the first cluster and all 3 with the
+  // second.
+  auto stats = CompareCommunity({2, 3, 4}, clustering);
+  EXPECT_DOUBLE_EQ(1, stats.community_precision().mean());
+  EXPECT_DOUBLE_EQ(1, stats.community_recall().mean());
+  EXPECT_DOUBLE_EQ(1, stats.f_score().mean());
+
+  stats = CompareCommunity({0, 1, 2}, clustering);
+  EXPECT_DOUBLE_EQ(0.75, stats.community_precision().mean());
+  EXPECT_DOUBLE_EQ(1, stats.community_recall().mean());
+  EXPECT_DOUBLE_EQ(2 * 0.75 / 1.75, stats.f_score().mean());
+}
+
+TEST(TestCommunities, TiesPickTheFirstCluster) {
+  std::vector<std::vector<gbbs::uintE>> clustering = {
+    { 0, 1, 7 },
+    { 2, 3 }
+  };
+  // Both clusters share 2 vertices with the community; the first one is used
+  // even though the second would give a higher precision.
+  auto stats = CompareCommunity({0, 1, 2, 3}, clustering);
+  EXPECT_DOUBLE_EQ(2.0 / 3, stats.community_precision().mean());
+  EXPECT_DOUBLE_EQ(0.5, stats.community_recall().mean());
+  EXPECT_DOUBLE_EQ(4.0 / 7, stats.f_score().mean());
+
+  stats = CompareCommunity({3, 2, 1, 0}, clustering);
+  EXPECT_DOUBLE_EQ(2.0 / 3, stats.community_precision().mean());
+}
+
+TEST(TestCommunities, NoMatchingCluster) {
+  std::vector<std::vector<gbbs::uintE>> clustering = {
+    { 0, 1, 7 },
+    { 2, 3 }
+  };
+  // Vertex 6 is in no cluster, and vertices 8 and 9 are past every clustered
+  // vertex.
+  for (const auto& community : std::vector<std::vector<gbbs::uintE>>{{6}, {8, 9}, {6, 9}}) {
+    auto stats = CompareCommunity(community, clustering);
+    EXPECT_EQ(0, stats.community_precision().mean());
+    EXPECT_EQ(0, stats.community_recall().mean());
+    EXPECT_EQ(0, stats.f_score().mean());
+  }
+}
+
+TEST(TestCommunities, SeveralCommunities) {
+  std::vector<std::vector<gbbs::uintE>> clustering = {
+    { 0, 1, 2, 3 },
+    { 2, 3, 4 },
+    { 5 }
+  };
+  std::vector<std::vector<gbbs::uintE>> communities = {
+    { 2, 3, 4 },
+    { 0, 1, 2 },
+    { 6 }
+  };
+  ClusteringStatistics clustering_stats;
+  ClusteringStatsConfig clustering_stats_config;
+  clustering_stats_config.set_compute_precision_recall(true);
+  ASSERT_TRUE(CompareCommunities(communities, clustering, &clustering_stats,
+                                 clustering_stats_config).ok());
+  EXPECT_EQ(3, clustering_stats.community_precision().count());
+  EXPECT_DOUBLE_EQ(1.75, clustering_stats.community_precision().total());
+  EXPECT_DOUBLE_EQ(0, clustering_stats.community_precision().minimum());
+  EXPECT_DOUBLE_EQ(1, clustering_stats.community_precision().maximum());
+  EXPECT_DOUBLE_EQ(2, clustering_stats.community_recall().total());
+}
@@ -0,0 +1,138 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "clusterers/clustering_stats.pb.h"
+#include "clusterers/gbbs_graph_io.h"
+#include "clusterers/stats/stats_diameter.h"
+#include "in_memory/status_macros.h"
+
+namespace research_graph::in_memory {
+namespace {
+
+// Returns the diameter statistics of `clustering` on the graph `edge_list`
+// with `n` vertices.
+DistributionStats Diameters(
+    std::size_t n, const std::vector<gbbs::gbbs_io::Edge<double>>& edge_list,
+    const std::vector<std::vector<gbbs::uintE>>& clustering, bool approximate) {
+  auto cluster_ids = parlay::sequence<gbbs::uintE>(n);
+  for (std::size_t i = 0; i < clustering.size(); i++) {
+    for (auto v : clustering[i]) cluster_ids[v] = i;
+  }
+  GbbsGraph graph;
+  EXPECT_TRUE(internal::WriteEdgeListAsGraph(&graph, edge_list, true).ok());
+
+  ClusteringStatistics clustering_stats;
+  ClusteringStatsConfig clustering_stats_config;
+  clustering_stats_config.set_compute_diameter(true);
+  clustering_stats_config.set_approximate_diameter(approximate);
+  EXPECT_TRUE(ComputeDiameter(graph, clustering, &clustering_stats, cluster_ids,
+                              clustering_stats_config).ok());
+  return clustering_stats.diameter();
+}
+
+// Returns the largest shortest-path distance between two of the `n` vertices
+// of the connected graph `edge_list`, with Floyd-Warshall.
+double AllPairsDiameter(
+    std::size_t n, const std::vector<gbbs::gbbs_io::Edge<double>>& edge_list) {
+  const double kInfinity = std::numeric_limits<double>::infinity();
+  std::vector<std::vector<double>> distances(n, std::vector<double>(n, kInfinity));
+  for (std::size_t i = 0; i < n; i++) distances[i][i] = 0;
+  for (const auto& edge : edge_list) {
+    // Single-precision weights, as stored in the graph.
+    double weight = static_cast<float>(edge.weight);
+    distances[edge.from][edge.to] = std::min(distances[edge.from][edge.to], weight);
+    distances[edge.to][edge.from] = std::min(distances[edge.to][edge.from], weight);
+  }
+  for (std::size_t k = 0; k < n; k++) {
+    for (std::size_t i = 0; i < n; i++) {
+      for (std::size_t j = 0; j < n; j++) {
+        distances[i][j] = std::min(distances[i][j], distances[i][k] + distances[k][j]);
+      }
+    }
+  }
+  double diameter = 0;
+  for (const auto& row : distances) {
+    diameter = std::max(diameter, *std::max_element(row.begin(), row.end()));
+  }
+  return diameter;
+}
+
+std::vector<gbbs::uintE> AllVertices(std::size_t n) {
+  std::vector<gbbs::uintE> vertices(n);
+  for (std::size_t i = 0; i < n; i++) vertices[i] = i;
+  return vertices;
+}
+
+// Checks the exact and approximate diameters of the single-cluster graph
+// `edge_list` against all-pairs shortest paths.
+void ExpectDiameter(std::size_t n,
+                    const std::vector<gbbs::gbbs_io::Edge<double>>& edge_list) {
+  const double expected = AllPairsDiameter(n, edge_list);
+  const auto exact = Diameters(n, edge_list, {AllVertices(n)}, false);
+  ASSERT_EQ(1, exact.count());
+  EXPECT_NEAR(expected, exact.mean(), 1e-5);
+
+  const auto approximate = Diameters(n, edge_list, {AllVertices(n)}, true);
+  ASSERT_EQ(1, approximate.count());
+  EXPECT_GE(approximate.mean(), expected / 2 - 1e-5);
+  EXPECT_LE(approximate.mean(), expected + 1e-5);
+}
+
+TEST(TestDiameter, Path) {
+  std::vector<gbbs::gbbs_io::Edge<double>> edge_list;
+  for (gbbs::uintE i = 0; i + 1 < 6; i++) edge_list.push_back({i, i + 1, 1});
+  EXPECT_EQ(5, AllPairsDiameter(6, edge_list));
+  ExpectDiameter(6, edge_list);
+  // A double sweep is exact on trees.
+  EXPECT_EQ(5, Diameters(6, edge_list, {AllVertices(6)}, true).mean());
+}
+
+TEST(TestDiameter, Cycle) {
+  for (gbbs::uintE n : {7, 8}) {
+    std::vector<gbbs::gbbs_io::Edge<double>> edge_list;
+    for (gbbs::uintE i = 0; i < n; i++) edge_list.push_back({i, (i + 1) % n, 1});
+    EXPECT_EQ(n / 2, AllPairsDiameter(n, edge_list));
+    ExpectDiameter(n, edge_list);
+  }
+}
+
+TEST(TestDiameter, Weighted) {
+  // The heavy chords are never shortest paths, while {2, 6} is.
+  const std::vector<gbbs::gbbs_io::Edge<double>> edge_list = {
+      {0, 1, 1}, {1, 2, 2}, {2, 3, 1}, {3, 4, 3}, {4, 5, 1}, {5, 6, 2},
+      {6, 7, 1}, {7, 0, 4}, {0, 4, 10}, {2, 6, 2.5}, {1, 5, 7}};
+  ExpectDiameter(8, edge_list);
+}
+
+TEST(TestDiameter, SeveralClusters) {
+  // A path {0, ..., 4} and a 6-cycle {5, ..., 10}, plus edges between them
+  // that no cluster keeps.
+  std::vector<gbbs::gbbs_io::Edge<double>> edge_list;
+  for (gbbs::uintE i = 0; i < 4; i++) edge_list.push_back({i, i + 1, 1});
+  for (gbbs::uintE i = 0; i < 6; i++) edge_list.push_back({5 + i, 5 + (i + 1) % 6, 1});
+  edge_list.push_back({0, 5, 1});
+  edge_list.push_back({4, 8, 1});
+  const auto diameters =
+      Diameters(11, edge_list, {{0, 1, 2, 3, 4}, {5, 6, 7, 8, 9, 10}}, false);
+  EXPECT_EQ(2, diameters.count());
+  EXPECT_EQ(3, diameters.minimum());
+  EXPECT_EQ(4, diameters.maximum());
+}
+
+TEST(TestDiameter, PartialClustering) {
+  // Only {3, 4, 5} of the path {0, ..., 5} is clustered. Vertices 0 to 2 keep
+  // the cluster id 0 of that cluster, but their edges must not join it.
+  std::vector<gbbs::gbbs_io::Edge<double>> edge_list;
+  for (gbbs::uintE i = 0; i + 1 < 6; i++) edge_list.push_back({i, i + 1, 1});
+  for (bool approximate : {false, true}) {
+    const auto diameters = Diameters(6, edge_list, {{3, 4, 5}}, approximate);
+    EXPECT_EQ(1, diameters.count());
+    EXPECT_EQ(2, diameters.mean());
+  }
+}
+
+}  // namespace
+}  // namespace research_graph::in_memory
@@ -1,5 +1,7 @@
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <tuple>
 #include <vector>
 
 #include "clusterers/stats/stats_nmi.h"
@@ -7,7 +9,10 @@
 #include "google/protobuf/repeated_field.h"
 #include "clusterers/clustering_stats.pb.h"
 
+using research_graph::in_memory::ComputeAMI;
+using research_graph::in_memory::ComputeContingencyTable;
 using research_graph::in_memory::ComputeNMI;
+using research_graph::in_memory::ComputeVMeasure;
 using research_graph::in_memory::ClusteringStatistics;
 using research_graph::in_memory::ClusteringStatsConfig;
 
@@ -178,4 +183,81 @@ TEST(TestNMI, TestReversibility) {
   ASSERT_TRUE(status2.ok());
 
   EXPECT_NEAR(clustering_stats.nmi(), clustering_stats.nmi(), pow(10,-10));
-}
\ No newline at end of file
+}
+
+TEST(TestAMI, TestAllSame) {
+  size_t n = 9;
+  std::vector<std::vector<gbbs::uintE>> clustering = {
+    { 1, 2, 3 }, // first cluster
+    { 4, 5, 6 }, // second cluster
+    { 7, 8, 9 }  // third cluster
+};
+  std::vector<std::vector<gbbs::uintE>> communities  = {
+    { 3, 2, 1 }, // first cluster
+    { 4, 5, 6 }, // second cluster
+    { 9, 8, 7 }  // third cluster
+};
+
+  ClusteringStatistics clustering_stats;
+  ClusteringStatsConfig clustering_stats_config;
+  clustering_stats_config.set_compute_ami(true);
+  clustering_stats_config.set_compute_v_measure(true);
+  auto table = ComputeContingencyTable(clustering, communities);
+  ASSERT_TRUE(ComputeAMI(n, table, &clustering_stats, clustering_stats_config).ok());
+  ASSERT_TRUE(ComputeVMeasure(n, table, &clustering_stats, clustering_stats_config).ok());
+  EXPECT_DOUBLE_EQ(1, clustering_stats.ami());
+  EXPECT_DOUBLE_EQ(1, clustering_stats.homogeneity());
+  EXPECT_DOUBLE_EQ(1, clustering_stats.completeness());
+  EXPECT_DOUBLE_EQ(1, clustering_stats.v_measure());
+}
+
+TEST(TestAMI, TestDifferentGridNum) {
+  // The contingency grid is
+  //  1 2
+  //  4 3
+  size_t n = 10;
+  std::vector<std::vector<gbbs::uintE>> clustering = {
+    { 1, 2, 3 }, // first cluster
+    { 4, 5, 6, 7, 8, 9, 10 }  // second cluster
+};
+  std::vector<std::vector<gbbs::uintE>> communities  = {
+    { 1, 7, 8, 9, 10}, // first cluster
+    { 2, 3, 4, 5, 6}, // second cluster
+};
+  ClusteringStatistics clustering_stats;
+  ClusteringStatsConfig clustering_stats_config;
+  clustering_stats_config.set_compute_ami(true);
+  clustering_stats_config.set_compute_v_measure(true);
+  auto table = ComputeContingencyTable(clustering, communities);
+  ASSERT_TRUE(ComputeAMI(n, table, &clustering_stats, clustering_stats_config).ok());
+  ASSERT_TRUE(ComputeVMeasure(n, table, &clustering_stats, clustering_stats_config).ok());
+  EXPECT_NEAR(-0.0711427521019998, clustering_stats.ami(), pow(10,-10));
+  EXPECT_NEAR(0.034851554559677034, clustering_stats.homogeneity(), pow(10,-10));
+  EXPECT_NEAR(0.039546027980205456, clustering_stats.completeness(), pow(10,-10));
+  // With equal weights, the V-measure is the NMI.
+  EXPECT_NEAR(0.03705068107641335, clustering_stats.v_measure(), pow(10,-10));
+}
+
+TEST(TestContingencyTable, TestOverlappingCommunities) {
+  // Vertices 2 and 3 are in both communities, so each of them is counted in
+  // one cell per community.
+  std::vector<std::vector<gbbs::uintE>> clustering = {
+    { 1, 2 }, // first cluster
+    { 3, 4 }  // second cluster
+};
+  std::vector<std::vector<gbbs::uintE>> communities  = {
+    { 1, 2, 3 }, // first community
+    { 2, 3, 4 }  // second community
+};
+  auto table = ComputeContingencyTable(clustering, communities);
+  auto cells = std::vector<std::tuple<gbbs::uintE, gbbs::uintE, std::size_t>>(
+      table.cells.begin(), table.cells.end());
+  std::sort(cells.begin(), cells.end());
+  std::vector<std::tuple<gbbs::uintE, gbbs::uintE, std::size_t>> expected = {
+      {0, 0, 2}, {0, 1, 1}, {1, 0, 1}, {1, 1, 2}};
+  EXPECT_EQ(expected, cells);
+  EXPECT_EQ(3, table.row_sums[0]);
+  EXPECT_EQ(3, table.row_sums[1]);
+  EXPECT_EQ(3, table.column_sums[0]);
+  EXPECT_EQ(3, table.column_sums[1]);
+}
@@ -0,0 +1,119 @@
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "clusterers/clustering_stats.pb.h"
+#include "clusterers/gbbs_graph_io.h"
+#include "clusterers/stats/stats_correlation.h"
+#include "google/protobuf/repeated_field.h"
+#include "google/protobuf/text_format.h"
+#include "in_memory/status_macros.h"
+
+namespace research_graph::in_memory {
+
+parlay::sequence<gbbs::uintE>
+GetClusteringIds(const std::size_t n,
+                 const std::vector<std::vector<gbbs::uintE>> &clustering) {
+  parlay::sequence<gbbs::uintE> cluster_ids = parlay::sequence<gbbs::uintE>(n);
+  parlay::parallel_for(0, clustering.size(), [&](size_t i) {
+    const auto &cluster = clustering[i];
+    parlay::parallel_for(0, cluster.size(),
+                         [&](size_t j) { cluster_ids[cluster[j]] = i; });
+  });
+  return cluster_ids;
+}
+
+TEST(TestObjectives, TestWeightedModularity) {
+  size_t n = 4;
+  std::vector<std::vector<gbbs::uintE>> clustering = {
+      {0, 1, 2},
+      {3},
+  };
+  const std::vector<gbbs::gbbs_io::Edge<double>> edge_list = {
+      {0, 1, 1}, {0, 2, 1}, {1, 2, 1}, {2, 3, 2}};
+
+  parlay::sequence<gbbs::uintE> cluster_ids = GetClusteringIds(n, clustering);
+
+  GbbsGraph graph;
+  ASSERT_OK_AND_ASSIGN(n,
+                       internal::WriteEdgeListAsGraph(&graph, edge_list, true));
+
+  ClusteringStatistics clustering_stats;
+  ClusteringStatsConfig clustering_stats_config;
+  clustering_stats_config.add_modularity_resolutions(1);
+  clustering_stats_config.add_modularity_resolutions(0.5);
+
+  ASSERT_OK(ComputeModularityObjective(graph, clustering, &clustering_stats,
+                                       cluster_ids, clustering_stats_config));
+  // Total weight 10, intra-cluster weight 6, cluster volumes 8 and 2.
+  ASSERT_EQ(2, clustering_stats.modularity_objective_size());
+  EXPECT_DOUBLE_EQ((6 - 68.0 / 10) / 10, clustering_stats.modularity_objective(0));
+  EXPECT_DOUBLE_EQ((6 - 0.5 * 68.0 / 10) / 10, clustering_stats.modularity_objective(1));
+}
+
+TEST(TestObjectives, TestCorrelation) {
+  size_t n = 4;
+  std::vector<std::vector<gbbs::uintE>> clustering = {
+      {0, 1, 2},
+      {3},
+  };
+  const std::vector<gbbs::gbbs_io::Edge<double>> edge_list = {
+      {0, 1, 1}, {0, 2, 1}, {1, 2, 1}, {2, 3, 2}};
+
+  parlay::sequence<gbbs::uintE> cluster_ids = GetClusteringIds(n, clustering);
+
+  GbbsGraph graph;
+  ASSERT_OK_AND_ASSIGN(n,
+                       internal::WriteEdgeListAsGraph(&graph, edge_list, true));
+
+  ClusteringStatistics clustering_stats;
+  ClusteringStatsConfig clustering_stats_config;
+  clustering_stats_config.add_correlation_resolutions(0);
+  clustering_stats_config.add_correlation_edge_weight_offsets(0);
+  clustering_stats_config.add_correlation_resolutions(0.5);
+  clustering_stats_config.add_correlation_edge_weight_offsets(1);
+
+  ASSERT_OK(ComputeCorrelationObjective(graph, clustering, &clustering_stats,
+                                        cluster_ids, clustering_stats_config));
+  ASSERT_EQ(2, clustering_stats.correlation_objective_size());
+  EXPECT_DOUBLE_EQ(3, clustering_stats.correlation_objective(0));
+  EXPECT_DOUBLE_EQ(-1.5, clustering_stats.correlation_objective(1));
+}
+
+TEST(TestObjectives, TestPartialClustering) {
+  size_t n = 4;
+  // Vertices 0 and 3 are in no cluster, but keep the cluster id 0 of {1, 2}.
+  std::vector<std::vector<gbbs::uintE>> clustering = {
+      {1, 2},
+  };
+  const std::vector<gbbs::gbbs_io::Edge<double>> edge_list = {
+      {0, 1, 1}, {0, 2, 1}, {1, 2, 1}, {2, 3, 2}};
+
+  parlay::sequence<gbbs::uintE> cluster_ids = GetClusteringIds(n, clustering);
+
+  GbbsGraph graph;
+  ASSERT_OK_AND_ASSIGN(n,
+                       internal::WriteEdgeListAsGraph(&graph, edge_list, true));
+
+  ClusteringStatistics clustering_stats;
+  ClusteringStatsConfig clustering_stats_config;
+  clustering_stats_config.add_modularity_resolutions(1);
+  clustering_stats_config.add_correlation_resolutions(0);
+  clustering_stats_config.add_correlation_edge_weight_offsets(0);
+  clustering_stats_config.add_correlation_resolutions(0.5);
+  clustering_stats_config.add_correlation_edge_weight_offsets(1);
+
+  ASSERT_OK(ComputeModularityObjective(graph, clustering, &clustering_stats,
+                                       cluster_ids, clustering_stats_config));
+  // Total weight 10, intra-cluster weight 2, cluster volume 6.
+  ASSERT_EQ(1, clustering_stats.modularity_objective_size());
+  EXPECT_DOUBLE_EQ((2 - 36.0 / 10) / 10, clustering_stats.modularity_objective(0));
+
+  ASSERT_OK(ComputeCorrelationObjective(graph, clustering, &clustering_stats,
+                                        cluster_ids, clustering_stats_config));
+  ASSERT_EQ(2, clustering_stats.correlation_objective_size());
+  EXPECT_DOUBLE_EQ(1, clustering_stats.correlation_objective(0));
+  EXPECT_DOUBLE_EQ(-0.5, clustering_stats.correlation_objective(1));
+}
+
+} // namespace research_graph::in_memory